@@ -0,0 +1,357 @@
+#include "hint_solver.hpp"
+#include "pips_data.hpp"
+#include "solver.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <new>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Every allocation in the process goes through here so solves can report how many they made
+namespace {
+std::atomic<std::uint64_t> g_allocations = 0;
+}
+
+void* operator new(std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size != 0 ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace pips {
+
+// Friend of Solver, exposes the private kernels to the benchmarks
+class SolverBench
+{
+public:
+    static bool check_zone_constraints(const Solver& solver, std::uint8_t zone_id, std::uint8_t pip)
+    {
+        return solver.check_zone_constraints(zone_id, pip);
+    }
+
+    static std::optional<std::uint8_t> find_unoccupied_cell(const Solver& solver)
+    {
+        return solver.find_unoccupied_cell();
+    }
+
+    // Forces a full recount so every call pays for the option counting, not just the scan
+    static std::optional<std::uint8_t> find_most_constrained_cell(Solver& solver)
+    {
+        solver.m_dirty_options = ~Bitboard{};
+        return solver.find_most_constrained_cell();
+    }
+};
+
+}  // namespace pips
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Difficulty = pips::NytJsonProvider::Difficulty;
+
+// Results are folded in here so the optimiser cannot drop the benchmarked calls
+volatile std::uint64_t g_sink = 0;
+
+struct Options
+{
+    std::vector<std::filesystem::path> inputs;
+    bool                               json = false;
+    std::chrono::milliseconds          min_time{50};
+    int                                repetitions = 5;
+};
+
+struct BenchGame
+{
+    std::string       name;
+    const pips::Game* game;
+};
+
+struct Measurement
+{
+    double        ns_per_op = 0;
+    std::uint64_t iterations = 0;
+};
+
+// Runs op() in growing batches until a batch lasts min_time, `repetitions` times, and keeps the
+// median time per call
+template <typename Op>
+Measurement measure(const Options& options, Op&& op)
+{
+    std::vector<double> samples;
+    std::uint64_t       iterations = 1;
+    for (int rep = 0; rep < options.repetitions; ++rep) {
+        while (true) {
+            const auto start = Clock::now();
+            for (std::uint64_t i = 0; i < iterations; ++i) {
+                op();
+            }
+            const auto elapsed = Clock::now() - start;
+            if (elapsed >= options.min_time || iterations >= (std::uint64_t{1} << 40)) {
+                samples.push_back(std::chrono::duration<double, std::nano>(elapsed).count() /
+                                  static_cast<double>(iterations));
+                break;
+            }
+            iterations *= 2;
+        }
+    }
+
+    std::ranges::sort(samples);
+    return {.ns_per_op = samples[samples.size() / 2], .iterations = iterations};
+}
+
+void report(const Options& options, std::string_view bench, const BenchGame& game, const nlohmann::json& fields)
+{
+    if (options.json) {
+        nlohmann::json line = {{"bench", bench}, {"game", game.name}};
+        line.update(fields);
+        std::println("{}", line.dump());
+        return;
+    }
+
+    std::string values;
+    for (const auto& [key, value] : fields.items()) {
+        if (value.is_number_float()) {
+            values += std::format("  {}={:.1f}", key, value.get<double>());
+        } else {
+            values += std::format("  {}={}", key, value.dump());
+        }
+    }
+    std::println("{:<28} {:<28}{}", bench, game.name, values);
+}
+
+// Lookup tables, most of it the zone assignments worked out before the search
+void bench_build_tables(const Options& options, const BenchGame& bench_game)
+{
+    const auto m = measure(options, [&] {
+        const auto tables = pips::build_tables(*bench_game.game);
+        g_sink = g_sink + tables.slots.size();
+    });
+
+    const auto restricted = std::ranges::count_if(bench_game.game->tables.zone_assignments,
+                                                  [](const auto& zone) { return zone.restricts(); });
+    report(options, "build_tables", bench_game, {{"ns_per_call", m.ns_per_op}, {"zones_restricted", restricted}});
+}
+
+void bench_check_zone_constraints(const Options& options, const BenchGame& bench_game)
+{
+    pips::Solver solver(*bench_game.game);
+    const auto   zones = bench_game.game->zones.size();
+
+    const auto m = measure(options, [&] {
+        std::uint64_t accepted = 0;
+        for (std::uint8_t zone_id = 0; zone_id < zones; ++zone_id) {
+            for (std::uint8_t pip = 0; pip <= pips::MAX_PIP; ++pip) {
+                accepted += pips::SolverBench::check_zone_constraints(solver, zone_id, pip);
+            }
+        }
+        g_sink = g_sink + accepted;
+    });
+
+    const auto calls = static_cast<double>(zones * (pips::MAX_PIP + 1));
+    report(options, "check_zone_constraints", bench_game, {{"ns_per_call", m.ns_per_op / calls}});
+}
+
+void bench_cell_selection(const Options& options, const BenchGame& bench_game)
+{
+    pips::Solver solver(*bench_game.game);
+
+    const auto row_major = measure(options, [&] {
+        g_sink = g_sink + pips::SolverBench::find_unoccupied_cell(solver).value_or(0);
+    });
+    report(options, "find_unoccupied_cell", bench_game, {{"ns_per_call", row_major.ns_per_op}});
+
+    const auto most_constrained = measure(options, [&] {
+        g_sink = g_sink + pips::SolverBench::find_most_constrained_cell(solver).value_or(0);
+    });
+    report(options, "find_most_constrained_cell", bench_game, {{"ns_per_call", most_constrained.ns_per_op}});
+}
+
+void bench_placement_enumeration(const Options& options, const BenchGame& bench_game)
+{
+    pips::Solver solver(*bench_game.game);
+    std::size_t  candidates = 0;
+
+    const auto m = measure(options, [&] {
+        candidates = solver.candidate_placements().size();
+        g_sink = g_sink + candidates;
+    });
+    report(options,
+           "candidate_placements",
+           bench_game,
+           {{"ns_per_call", m.ns_per_op}, {"candidates", candidates}});
+}
+
+// Full solves on the BoardSolver instantiation, reported under `bench`
+template <typename BoardSolver>
+void bench_solve(const Options& options, const BenchGame& bench_game, std::string_view bench)
+{
+    std::uint64_t nodes = 0;
+    std::uint64_t allocations = 0;
+    bool          solved = false;
+
+    const auto m = measure(options, [&] {
+        const auto  allocations_before = g_allocations.load(std::memory_order_relaxed);
+        BoardSolver solver(*bench_game.game);
+        solved = solver.solve().has_value();
+        allocations = g_allocations.load(std::memory_order_relaxed) - allocations_before;
+        nodes = solver.nodes();
+    });
+
+    const double ns_per_node = nodes != 0 ? m.ns_per_op / static_cast<double>(nodes) : 0.0;
+    report(options,
+           bench,
+           bench_game,
+           {{"solved", solved},
+            {"ns_per_solve", m.ns_per_op},
+            {"nodes", nodes},
+            {"ns_per_node", ns_per_node},
+            {"nodes_per_s", ns_per_node != 0 ? 1e9 / ns_per_node : 0.0},
+            {"allocs_per_solve", allocations}});
+}
+
+// Hints on a half-filled board: calls that alternately lay one more of the official placements and
+// take it back, answered by one HintSolver and by a fresh one per call
+void bench_hint(const Options& options, const BenchGame& bench_game)
+{
+    const auto& game = *bench_game.game;
+    if (game.official_solution.size() != game.dominoes.size())
+        return;
+
+    std::vector<pips::DominoPlacement> official;
+    for (std::size_t i = 0; i < game.dominoes.size(); ++i) {
+        const auto& domino = game.dominoes[i];
+        const auto& [cell1, cell2] = game.official_solution[i];
+        official.push_back({domino, {cell1, domino.p1}, {cell2, domino.p2}});
+    }
+    const auto half = official.size() / 2;
+    const auto boards = std::array{std::span<const pips::DominoPlacement>(official).first(half),
+                                   std::span<const pips::DominoPlacement>(official).first(half + 1)};
+
+    // The synthetic boards' official solutions are placeholders, nothing can be hinted from them
+    pips::HintSolver hints(game);
+    if (const auto full = hints.solve(official); !full || full->status != pips::SolveStatus::SOLVED)
+        return;
+
+    std::size_t call = 0;
+    bool        solved = true;
+    const auto  answer = [&](pips::HintSolver& solver) {
+        const auto result = solver.solve(boards[call++ % boards.size()]);
+        solved = solved && result && result->status == pips::SolveStatus::SOLVED;
+    };
+
+    const auto reused = measure(options, [&] { answer(hints); });
+    const auto fresh = measure(options, [&] {
+        pips::HintSolver cold(game);
+        answer(cold);
+    });
+
+    report(options,
+           "hint",
+           bench_game,
+           {{"solved", solved},
+            {"fixed", half},
+            {"ns_per_hint", reused.ns_per_op},
+            {"ns_per_cold_hint", fresh.ns_per_op}});
+}
+
+std::vector<std::filesystem::path> collect_files(const std::vector<std::filesystem::path>& inputs)
+{
+    std::vector<std::filesystem::path> files;
+    for (const auto& input : inputs) {
+        if (std::filesystem::is_directory(input)) {
+            std::vector<std::filesystem::path> dir_files;
+            for (const auto& entry : std::filesystem::directory_iterator(input)) {
+                if (entry.path().extension() == ".json")
+                    dir_files.push_back(entry.path());
+            }
+            std::ranges::sort(dir_files);
+            files.insert(files.end(), dir_files.begin(), dir_files.end());
+        } else {
+            files.push_back(input);
+        }
+    }
+    return files;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--json") {
+            options.json = true;
+        } else if (arg == "--min-time-ms" && i + 1 < argc) {
+            options.min_time = std::chrono::milliseconds(std::strtol(argv[++i], nullptr, 10));
+        } else if (arg == "--repetitions" && i + 1 < argc) {
+            options.repetitions = std::max(1, static_cast<int>(std::strtol(argv[++i], nullptr, 10)));
+        } else if (arg.starts_with("-")) {
+            std::println(std::cerr,
+                         "Usage: {} [--json] [--min-time-ms N] [--repetitions N] [FILE_OR_DIR...]",
+                         argv[0]);
+            return 1;
+        } else {
+            options.inputs.emplace_back(arg);
+        }
+    }
+    if (options.inputs.empty()) {
+        options.inputs.emplace_back(PIPS_BENCH_CORPUS);
+    }
+
+    std::vector<pips::NytJsonProvider> providers;
+    std::vector<std::string>           file_names;
+    for (const auto& file : collect_files(options.inputs)) {
+        auto provider = pips::NytJsonProvider::create(file);
+        if (!provider) {
+            std::println(std::cerr, "Error: {}", provider.error());
+            return 1;
+        }
+        providers.push_back(std::move(*provider));
+        file_names.push_back(file.stem().string());
+    }
+
+    std::vector<BenchGame> games;
+    for (std::size_t i = 0; i < providers.size(); ++i) {
+        for (auto difficulty : {Difficulty::EASY, Difficulty::MEDIUM, Difficulty::HARD}) {
+            games.push_back({.name = file_names[i] + ":" + std::string(pips::NytJsonProvider::to_string(difficulty)),
+                             .game = &providers[i].get_game(difficulty)});
+        }
+    }
+
+    for (const auto& game : games) {
+        bench_build_tables(options, game);
+        bench_check_zone_constraints(options, game);
+        bench_cell_selection(options, game);
+        bench_placement_enumeration(options, game);
+        bench_solve<pips::Solver>(options, game, "solve");
+        if (game.game->dim.rows * game.game->dim.cols <= pips::CompactSolver::CAPACITY)
+            bench_solve<pips::CompactSolver>(options, game, "solve_compact");
+        bench_hint(options, game);
+    }
+
+    return 0;
+}
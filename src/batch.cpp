@@ -0,0 +1,224 @@
+#include "batch.hpp"
+
+#include "pips_data.hpp"
+#include "puzzle_archive.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <print>
+#include <thread>
+
+namespace pips {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// A game of the batch, parsed from a puzzle file or viewed in an archive
+struct BatchGame
+{
+    std::string                    name;
+    NytJsonProvider::Difficulty    difficulty;
+    const Game*                    game = nullptr;
+    const PuzzleArchive::GameView* packed = nullptr;
+};
+
+struct GameResult
+{
+    SolveStatus                               status = SolveStatus::UNSATISFIABLE;
+    std::uint64_t                             nodes = 0;
+    std::chrono::duration<double, std::milli> time{};
+};
+
+// Runs job(i) for every i in [0, count) on `threads` workers
+template <typename Job>
+void parallel_for(std::size_t count, unsigned threads, Job&& job)
+{
+    std::atomic<std::size_t> next = 0;
+    const auto               worker = [&] {
+        for (std::size_t i = next++; i < count; i = next++) {
+            job(i);
+        }
+    };
+
+    std::vector<std::jthread> workers;
+    for (unsigned t = 1; t < threads; ++t) {
+        workers.emplace_back(worker);
+    }
+    worker();
+}
+
+// Nearest-rank percentile of sorted samples
+double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+    const auto rank = static_cast<std::size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+    return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+}
+
+}  // namespace
+
+std::expected<std::vector<std::filesystem::path>, std::string> collect_puzzle_files(
+    const std::vector<std::filesystem::path>& inputs)
+{
+    std::vector<std::filesystem::path> files;
+    for (const auto& input : inputs) {
+        std::error_code ec;
+        if (std::filesystem::is_directory(input, ec)) {
+            std::vector<std::filesystem::path> dir_files;
+            for (const auto& entry : std::filesystem::directory_iterator(input, ec)) {
+                const auto extension = entry.path().extension();
+                if (entry.is_regular_file() && (extension == ".json" || extension == PuzzleArchive::EXTENSION))
+                    dir_files.push_back(entry.path());
+            }
+            std::ranges::sort(dir_files);
+            files.insert(files.end(), dir_files.begin(), dir_files.end());
+        } else if (std::filesystem::is_regular_file(input, ec)) {
+            files.push_back(input);
+        } else {
+            return std::unexpected("No such puzzle file or directory: " + input.string());
+        }
+    }
+    return files;
+}
+
+std::expected<std::size_t, std::string> run_batch(const std::vector<std::filesystem::path>& inputs,
+                                                  unsigned                                  threads,
+                                                  EngineKind                                engine,
+                                                  SolverOptions                             options,
+                                                  std::chrono::milliseconds                 time_limit,
+                                                  std::uint64_t                             node_budget)
+{
+    auto files_or_error = collect_puzzle_files(inputs);
+    if (!files_or_error) {
+        return std::unexpected(files_or_error.error());
+    }
+    const auto& files = *files_or_error;
+
+    threads = std::max(threads != 0 ? threads : std::thread::hardware_concurrency(), 1u);
+
+    const auto batch_start = Clock::now();
+
+    // Parse every file up front so the solve phase only holds solver work, archives are only
+    // mapped and their games unpacked by the worker that solves them
+    std::vector<std::optional<NytJsonProvider>> providers(files.size());
+    std::vector<std::optional<PuzzleArchive>>   archives(files.size());
+    std::mutex                                  output_mutex;
+    parallel_for(files.size(), threads, [&](std::size_t i) {
+        std::string error;
+        if (files[i].extension() == PuzzleArchive::EXTENSION) {
+            auto archive = PuzzleArchive::open(files[i]);
+            if (archive) {
+                archives[i] = std::move(*archive);
+                return;
+            }
+            error = std::move(archive.error());
+        } else {
+            auto provider = NytJsonProvider::create(files[i]);
+            if (provider) {
+                providers[i] = std::move(*provider);
+                return;
+            }
+            error = std::move(provider.error());
+        }
+        std::scoped_lock lock(output_mutex);
+        std::println(std::cerr, "{}", error);
+    });
+
+    constexpr std::array difficulties = {NytJsonProvider::Difficulty::EASY,
+                                         NytJsonProvider::Difficulty::MEDIUM,
+                                         NytJsonProvider::Difficulty::HARD};
+
+    std::vector<BatchGame> games;
+    std::size_t            load_failures = 0;
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        if (providers[i]) {
+            for (auto difficulty : difficulties) {
+                games.push_back({.name = files[i].filename().string(),
+                                 .difficulty = difficulty,
+                                 .game = &providers[i]->get_game(difficulty)});
+            }
+        } else if (archives[i]) {
+            for (std::size_t g = 0; g < archives[i]->size(); ++g) {
+                const auto& packed = (*archives[i])[g];
+                games.push_back(
+                    {.name = std::string(packed.name()), .difficulty = packed.difficulty(), .packed = &packed});
+            }
+        } else {
+            load_failures++;
+        }
+    }
+
+    std::vector<GameResult> results(games.size());
+    parallel_for(games.size(), threads, [&](std::size_t i) {
+        const auto& [name, difficulty, parsed, packed] = games[i];
+
+        std::optional<Game> unpacked;
+        const Game&         game = parsed != nullptr ? *parsed : unpacked.emplace(packed->to_game());
+
+        // Games already run one per thread, each engine searches on its own
+        const auto  solver = make_engine(engine, game, options);
+        const auto  start = Clock::now();
+        SolveLimits limits{.node_budget = node_budget};
+        if (time_limit.count() > 0) {
+            limits.deadline = start + time_limit;
+        }
+        const auto result = solver->solve(limits);
+        const auto status = result.status;
+        results[i] = {.status = status, .nodes = solver->stats().nodes, .time = Clock::now() - start};
+
+        std::scoped_lock lock(output_mutex);
+        std::println("{:<20} {:<6} {:<8} {:>10.3f}ms {:>12} nodes  {}",
+                     name,
+                     NytJsonProvider::to_string(difficulty),
+                     status == SolveStatus::SOLVED      ? "solved"
+                     : status == SolveStatus::TIMED_OUT ? "TIMEOUT"
+                                                        : "UNSOLVED",
+                     results[i].time.count(),
+                     results[i].nodes,
+                     result.configuration);
+    });
+
+    const std::chrono::duration<double> wall_time = Clock::now() - batch_start;
+
+    std::vector<double> latencies;
+    latencies.reserve(results.size());
+    std::uint64_t total_nodes = 0;
+    std::size_t   unsolved = 0;
+    std::size_t   timed_out = 0;
+    for (const auto& result : results) {
+        latencies.push_back(result.time.count());
+        total_nodes += result.nodes;
+        unsolved += result.status != SolveStatus::SOLVED;
+        timed_out += result.status == SolveStatus::TIMED_OUT;
+    }
+    std::ranges::sort(latencies);
+
+    std::println("");
+    std::println("files: {} ({} failed to load)  games: {}  unsolved: {} ({} timed out)",
+                 files.size(),
+                 load_failures,
+                 games.size(),
+                 unsolved,
+                 timed_out);
+    std::println("wall: {:.3f}s on {} threads, {} engine  throughput: {:.1f} games/s, {:.0f} nodes/s",
+                 wall_time.count(),
+                 threads,
+                 to_string(engine),
+                 static_cast<double>(games.size()) / wall_time.count(),
+                 static_cast<double>(total_nodes) / wall_time.count());
+    std::println("latency: p50 {:.3f}ms  p99 {:.3f}ms  max {:.3f}ms",
+                 percentile(latencies, 0.50),
+                 percentile(latencies, 0.99),
+                 latencies.empty() ? 0.0 : latencies.back());
+
+    return unsolved + load_failures * difficulties.size();
+}
+
+}  // namespace pips
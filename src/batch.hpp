@@ -0,0 +1,32 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "solver_engine.hpp"
+
+namespace pips {
+
+// Expands the directories of `inputs` into their *.json and *.pips files, sorted by name, and
+// keeps the other inputs as given
+std::expected<std::vector<std::filesystem::path>, std::string> collect_puzzle_files(
+    const std::vector<std::filesystem::path>& inputs);
+
+// Solves every easy/medium/hard game of the given puzzle files on `threads` workers (0 uses
+// every hardware thread). Directories are searched for *.json and *.pips files, *.pips are opened as
+// puzzle archives and all their games solved. One line is printed per game as soon as it is
+// solved, followed by throughput and latency totals. Each game gets up to `time_limit` (0 for no
+// limit) and `node_budget` nodes (0 for no budget), a game that runs out counts as unsolved.
+// Returns the number of games left unsolved, counting three games for every file that failed to load.
+std::expected<std::size_t, std::string> run_batch(const std::vector<std::filesystem::path>& inputs,
+                                                  unsigned                                  threads,
+                                                  EngineKind                                engine,
+                                                  SolverOptions                             options = {},
+                                                  std::chrono::milliseconds                 time_limit = {},
+                                                  std::uint64_t                             node_budget = 0);
+
+}  // namespace pips
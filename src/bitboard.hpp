@@ -0,0 +1,155 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace pips {
+
+// Fixed-width set of board cells, addressed by the flat cell index (row * cols + col). The word
+// count is a template parameter so boards that fit in one word get single-instruction operations.
+template <std::size_t Words>
+class BasicBitboard
+{
+public:
+    static constexpr std::size_t WORD_BITS = 64;
+    static constexpr std::size_t WORDS = Words;
+    static constexpr std::size_t CAPACITY = WORDS * WORD_BITS;
+
+    constexpr BasicBitboard() noexcept = default;
+
+    // Bits [0, n) set
+    static constexpr BasicBitboard first_n(std::size_t n) noexcept
+    {
+        BasicBitboard bb;
+        for (std::size_t w = 0; w < WORDS && n > 0; ++w) {
+            const std::size_t take = n < WORD_BITS ? n : WORD_BITS;
+            bb.m_words[w] = take == WORD_BITS ? ~std::uint64_t{0} : (std::uint64_t{1} << take) - 1;
+            n -= take;
+        }
+        return bb;
+    }
+
+    constexpr void set(std::uint8_t idx) noexcept { m_words[idx / WORD_BITS] |= bit(idx); }
+    constexpr void reset(std::uint8_t idx) noexcept { m_words[idx / WORD_BITS] &= ~bit(idx); }
+    [[nodiscard]] constexpr bool test(std::uint8_t idx) const noexcept
+    {
+        return (m_words[idx / WORD_BITS] & bit(idx)) != 0;
+    }
+
+    [[nodiscard]] constexpr bool none() const noexcept
+    {
+        std::uint64_t acc = 0;
+        for (auto w : m_words)
+            acc |= w;
+        return acc == 0;
+    }
+    [[nodiscard]] constexpr bool any() const noexcept { return !none(); }
+
+    [[nodiscard]] constexpr int count() const noexcept
+    {
+        int total = 0;
+        for (auto w : m_words)
+            total += std::popcount(w);
+        return total;
+    }
+
+    // Index of the lowest set bit, the bitboard must not be empty
+    [[nodiscard]] constexpr std::uint8_t lowest() const noexcept
+    {
+        for (std::size_t w = 0; w + 1 < WORDS; ++w) {
+            if (m_words[w] != 0)
+                return static_cast<std::uint8_t>(w * WORD_BITS + std::countr_zero(m_words[w]));
+        }
+        return static_cast<std::uint8_t>((WORDS - 1) * WORD_BITS + std::countr_zero(m_words[WORDS - 1]));
+    }
+
+    // Removes the lowest set bit and returns its index, the bitboard must not be empty
+    constexpr std::uint8_t pop_lowest() noexcept
+    {
+        const auto idx = lowest();
+        reset(idx);
+        return idx;
+    }
+
+    constexpr BasicBitboard& operator&=(const BasicBitboard& other) noexcept
+    {
+        for (std::size_t w = 0; w < WORDS; ++w)
+            m_words[w] &= other.m_words[w];
+        return *this;
+    }
+    constexpr BasicBitboard& operator|=(const BasicBitboard& other) noexcept
+    {
+        for (std::size_t w = 0; w < WORDS; ++w)
+            m_words[w] |= other.m_words[w];
+        return *this;
+    }
+    constexpr BasicBitboard& operator^=(const BasicBitboard& other) noexcept
+    {
+        for (std::size_t w = 0; w < WORDS; ++w)
+            m_words[w] ^= other.m_words[w];
+        return *this;
+    }
+
+    friend constexpr BasicBitboard operator&(BasicBitboard lhs, const BasicBitboard& rhs) noexcept
+    {
+        return lhs &= rhs;
+    }
+    friend constexpr BasicBitboard operator|(BasicBitboard lhs, const BasicBitboard& rhs) noexcept
+    {
+        return lhs |= rhs;
+    }
+    friend constexpr BasicBitboard operator^(BasicBitboard lhs, const BasicBitboard& rhs) noexcept
+    {
+        return lhs ^= rhs;
+    }
+
+    constexpr BasicBitboard operator~() const noexcept
+    {
+        BasicBitboard bb;
+        for (std::size_t w = 0; w < WORDS; ++w)
+            bb.m_words[w] = ~m_words[w];
+        return bb;
+    }
+
+    // Moves every cell index down by n (cell i + n lands on bit i)
+    constexpr BasicBitboard operator>>(std::size_t n) const noexcept
+    {
+        BasicBitboard     bb;
+        const std::size_t word_shift = n / WORD_BITS;
+        const unsigned    bit_shift = n % WORD_BITS;
+        for (std::size_t w = 0; w + word_shift < WORDS; ++w) {
+            bb.m_words[w] = m_words[w + word_shift] >> bit_shift;
+            if (bit_shift != 0 && w + word_shift + 1 < WORDS)
+                bb.m_words[w] |= m_words[w + word_shift + 1] << (WORD_BITS - bit_shift);
+        }
+        return bb;
+    }
+
+    // Moves every cell index up by n (cell i lands on bit i + n)
+    constexpr BasicBitboard operator<<(std::size_t n) const noexcept
+    {
+        BasicBitboard     bb;
+        const std::size_t word_shift = n / WORD_BITS;
+        const unsigned    bit_shift = n % WORD_BITS;
+        for (std::size_t w = WORDS; w-- > word_shift;) {
+            bb.m_words[w] = m_words[w - word_shift] << bit_shift;
+            if (bit_shift != 0 && w > word_shift)
+                bb.m_words[w] |= m_words[w - word_shift - 1] >> (WORD_BITS - bit_shift);
+        }
+        return bb;
+    }
+
+    constexpr bool operator==(const BasicBitboard&) const noexcept = default;
+
+private:
+    static constexpr std::uint64_t bit(std::uint8_t idx) noexcept { return std::uint64_t{1} << (idx % WORD_BITS); }
+
+    std::array<std::uint64_t, WORDS> m_words{};
+};
+
+// Wide enough for every board up to MAX_BOARD_CELLS
+using Bitboard = BasicBitboard<2>;
+
+}  // namespace pips
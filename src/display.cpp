@@ -1,11 +1,15 @@
 #include "display.hpp"
 
+#include <unistd.h>
+
 #include <array>
+#include <cstdio>
+#include <cstdlib>
 #include <format>
-#include <map>
-#include <print>
+#include <iterator>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 namespace {
@@ -27,9 +31,14 @@ constexpr std::string_view HOLE_COLOR = "\033[48;2;40;40;40m";
 constexpr std::string_view DICE_COLOR = "\033[38;2;255;255;255m";
 constexpr std::string_view BORDER_COLOR = "\033[38;2;150;150;150m";
 
+// Glyphs the renderer puts in canvas cells, pips and zone labels are single characters of these
+constexpr std::string_view DIGITS = "0123456789";
+constexpr std::string_view ZONE_LABELS = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+// Every field views a constant, so the canvas holds no strings of its own
 struct DisplayCell
 {
-    std::string      content = " ";
+    std::string_view content = " ";
     std::string_view fg = RESET_COLOR;
     std::string_view bg = RESET_COLOR;
 };
@@ -72,12 +81,74 @@ std::string_view to_string(pips::RegionType type)
     return "Unknown";
 }
 
+// Appends the formatted line and a newline to `out`
+template <typename... Args>
+void append_line(std::string& out, std::format_string<Args...> fmt, Args&&... args)
+{
+    std::format_to(std::back_inserter(out), fmt, std::forward<Args>(args)...);
+    out += '\n';
+}
+
+void append_stats(std::string& out, const pips::SolverStats& stats)
+{
+    append_line(out, "Search: {} nodes", stats.nodes);
+    if (!pips::SolverStats::ENABLED)
+        return;
+
+    append_line(out,
+                "  backtracks: {}, max depth: {}, dead cells: {}, untileable regions: {}",
+                stats.backtracks,
+                stats.max_depth,
+                stats.dead_cells,
+                stats.region_prunes);
+
+    std::string prunes;
+    for (std::size_t type = 0; type < stats.prunes_by_region.size(); ++type) {
+        if (stats.prunes_by_region[type] != 0)
+            prunes += std::format(
+                " {}={}", to_string(static_cast<pips::RegionType>(type)), stats.prunes_by_region[type]);
+    }
+    append_line(out, "  prunes by zone:{}", prunes.empty() ? " none" : prunes);
+    if (const auto lookups = stats.transposition_hits + stats.transposition_misses; lookups != 0) {
+        append_line(out, "  transpositions: {} hits / {} lookups", stats.transposition_hits, lookups);
+    }
+    if (stats.backjumped_levels != 0 || stats.nogood_prunes != 0) {
+        append_line(out, "  backjumped levels: {}, nogood prunes: {}", stats.backjumped_levels, stats.nogood_prunes);
+    }
+
+    // Mean children explored per node at each depth
+    std::string branching;
+    for (const auto& histogram : stats.branching) {
+        std::uint64_t nodes = 0;
+        std::uint64_t children = 0;
+        for (std::size_t b = 0; b < histogram.size(); ++b) {
+            nodes += histogram[b];
+            children += b * histogram[b];
+        }
+        branching += std::format(" {:.2f}", nodes != 0 ? static_cast<double>(children) / nodes : 0.0);
+    }
+    append_line(out, "  branching by depth:{}", branching);
+}
+
+std::string_view zone_label(std::size_t zone)
+{
+    return zone < ZONE_LABELS.size() ? ZONE_LABELS.substr(zone, 1) : "?";
+}
+
 }  // namespace
 
-void pips::print_game_solution(const pips::Game&                         game,
-                               const std::vector<pips::DominoPlacement>& solution,
-                               const std::chrono::duration<double>&      solver_time,
-                               pips::NytJsonProvider::Difficulty         difficulty)
+bool pips::stdout_supports_color()
+{
+    const char* no_color = std::getenv("NO_COLOR");
+    return ::isatty(STDOUT_FILENO) != 0 && (no_color == nullptr || *no_color == '\0');
+}
+
+std::string pips::render_game_solution(const pips::Game&                         game,
+                                       const std::vector<pips::DominoPlacement>& solution,
+                                       const std::chrono::duration<double>&      solver_time,
+                                       pips::NytJsonProvider::Difficulty         difficulty,
+                                       const pips::SolverStats&                  stats,
+                                       bool                                      color)
 {
     auto difficulty_to_string = [](pips::NytJsonProvider::Difficulty d) {
         switch (d) {
@@ -91,55 +162,62 @@ void pips::print_game_solution(const pips::Game&                         game,
         return "Unknown";
     };
 
-    std::println("\n╔═══════════════════════════════════════════╗");
-    std::println("║   GAME: {:^31}   ║", difficulty_to_string(difficulty));
-    std::println("╚═══════════════════════════════════════════╝");
-    std::println("\nSolver Time: {}", format_time(solver_time));
+    const std::size_t cols = game.dim.cols;
+    const std::size_t cell_count = game.dim.rows * cols;
 
-    // Pre-computation
-    std::vector<std::vector<int>> pips_grid(game.dim.rows, std::vector<int>(game.dim.cols, -1));
-    std::map<GridCell, int>       domino_id_map;
+    // Grid Canvas Construction
+    const std::size_t        canvas_rows = game.dim.rows * 2 + 1;
+    const std::size_t        canvas_cols = cols * 4 + 1;
+    std::vector<DisplayCell> canvas(canvas_rows * canvas_cols);
 
-    for (int i = 0; const auto& p : solution) {
-        pips_grid[p.placement1.cell.row][p.placement1.cell.col] = p.placement1.pip;
-        pips_grid[p.placement2.cell.row][p.placement2.cell.col] = p.placement2.pip;
-        domino_id_map[p.placement1.cell] = i;
-        domino_id_map[p.placement2.cell] = i++;
-    }
+    const auto at = [&](std::size_t r, std::size_t c) -> DisplayCell& { return canvas[r * canvas_cols + c]; };
+
+    std::string out;
+    // Each canvas cell costs at most two colour escapes, a reset and a three-byte glyph
+    out.reserve(1024 + canvas.size() * (color ? 48 : 3));
+
+    append_line(out, "\n╔═══════════════════════════════════════════╗");
+    append_line(out, "║   GAME: {:^31}   ║", difficulty_to_string(difficulty));
+    append_line(out, "╚═══════════════════════════════════════════╝");
+    append_line(out, "\nSolver Time: {}", format_time(solver_time));
+    append_stats(out, stats);
 
-    std::vector<std::string_view>        region_colors(game.zones.size());
-    std::map<GridCell, std::string_view> cell_colors;
-    for (std::size_t i = 0; const auto& zone : game.zones) {
-        region_colors[i] = REGION_COLORS[i % REGION_COLORS.size()];
-        for (const auto& cell : zone.indices) {
-            cell_colors[cell] = region_colors[i];
+    // Pip and domino of every cell by flat index, -1 for a hole
+    std::vector<int> pips_grid(cell_count, -1);
+    std::vector<int> domino_of(cell_count, -1);
+    for (int i = 0; const auto& p : solution) {
+        for (const auto& placed : {p.placement1, p.placement2}) {
+            pips_grid[placed.cell.row * cols + placed.cell.col] = placed.pip;
+            domino_of[placed.cell.row * cols + placed.cell.col] = i;
         }
         i++;
     }
 
-    // Grid Canvas Construction
-    const std::size_t                     canvas_rows = game.dim.rows * 2 + 1;
-    const std::size_t                     canvas_cols = game.dim.cols * 4 + 1;
-    std::vector<std::vector<DisplayCell>> canvas(canvas_rows, std::vector<DisplayCell>(canvas_cols));
-
-    for (std::uint8_t r = 0; r < game.dim.rows; ++r) {
-        for (std::uint8_t c = 0; c < game.dim.cols; ++c) {
-            const int pip = pips_grid[r][c];
+    for (std::size_t r = 0; r < game.dim.rows; ++r) {
+        for (std::size_t c = 0; c < cols; ++c) {
+            const int pip = pips_grid[r * cols + c];
 
             // Canvas coordinates for the center of the cell
             const std::size_t canvas_r = r * 2 + 1;
             const std::size_t canvas_c = c * 4 + 2;
 
             if (pip == -1) {  //  hole
-                for (std::size_t i = 0; i < 3; ++i)
-                    canvas[canvas_r][canvas_c - 1 + i].bg = HOLE_COLOR;
+                for (std::size_t i = 0; i < 3; ++i) {
+                    at(canvas_r, canvas_c - 1 + i).bg = HOLE_COLOR;
+                    if (!color)
+                        at(canvas_r, canvas_c - 1 + i).content = "░";
+                }
             } else {  // domino part
-                auto color = cell_colors.at({r, c});
-                canvas[canvas_r][canvas_c - 1].bg = color;
-                canvas[canvas_r][canvas_c].content = std::to_string(pip);
-                canvas[canvas_r][canvas_c].fg = DICE_COLOR;
-                canvas[canvas_r][canvas_c].bg = color;
-                canvas[canvas_r][canvas_c + 1].bg = color;
+                const auto zone_id = game.tables.zone_of[r * cols + c];
+                const auto zone_color = REGION_COLORS[zone_id % REGION_COLORS.size()];
+                at(canvas_r, canvas_c - 1).bg = zone_color;
+                at(canvas_r, canvas_c).content = DIGITS.substr(pip, 1);
+                at(canvas_r, canvas_c).fg = DICE_COLOR;
+                at(canvas_r, canvas_c).bg = zone_color;
+                at(canvas_r, canvas_c + 1).bg = zone_color;
+                // Without colours the zone shows as its legend label next to the pip
+                if (!color && zone_id != GameTables::NO_ZONE && game.zones[zone_id].type != RegionType::EMPTY)
+                    at(canvas_r, canvas_c + 1).content = zone_label(zone_id);
             }
         }
     }
@@ -153,58 +231,90 @@ void pips::print_game_solution(const pips::Game&                         game,
             if (!is_row_sep && !is_col_sep)
                 continue;
 
-            canvas[r][c].fg = BORDER_COLOR;
+            at(r, c).fg = BORDER_COLOR;
 
             if (is_row_sep && is_col_sep) {  // Junctions
-                canvas[r][c].content = "┼";
+                at(r, c).content = "┼";
             } else if (is_row_sep) {
-                canvas[r][c].content = "─";
+                at(r, c).content = "─";
             } else {
-                canvas[r][c].content = "│";
+                at(r, c).content = "│";
             }
         }
     }
 
     // Erase internal domino borders
-    for (const auto& [cell, id] : domino_id_map) {
-        // Horizontal check
-        if (domino_id_map.count({cell.row, (std::uint8_t)(cell.col + 1)}) &&
-            domino_id_map.at({cell.row, (uint8_t)(cell.col + 1)}) == id) {
-            for (std::size_t i = 0; i < 3; ++i)
-                canvas[cell.row * 2 + i][cell.col * 4 + 4] = {};
-        }
-        // Vertical check
-        if (domino_id_map.count({(std::uint8_t)(cell.row + 1), cell.col}) &&
-            domino_id_map.at({(std::uint8_t)(cell.row + 1), cell.col}) == id) {
-            for (std::size_t i = 0; i < 5; ++i)
-                canvas[cell.row * 2 + 2][cell.col * 4 + i] = {};
+    for (std::size_t r = 0; r < game.dim.rows; ++r) {
+        for (std::size_t c = 0; c < cols; ++c) {
+            const int id = domino_of[r * cols + c];
+            if (id == -1)
+                continue;
+            // Horizontal check
+            if (c + 1 < cols && domino_of[r * cols + c + 1] == id) {
+                for (std::size_t i = 0; i < 3; ++i)
+                    at(r * 2 + i, c * 4 + 4) = {};
+            }
+            // Vertical check
+            if (r + 1 < game.dim.rows && domino_of[(r + 1) * cols + c] == id) {
+                for (std::size_t i = 0; i < 5; ++i)
+                    at(r * 2 + 2, c * 4 + i) = {};
+            }
         }
     }
 
-    // Render
+    // Render, colours are only switched where they change along a row
     for (std::size_t r = 0; r < canvas_rows; ++r) {
+        std::string_view fg = RESET_COLOR;
+        std::string_view bg = RESET_COLOR;
         for (std::size_t c = 0; c < canvas_cols; ++c) {
-            const auto& cell = canvas[r][c];
-            if (cell.bg != RESET_COLOR)
-                std::print("{}", cell.bg);
-            if (cell.fg != RESET_COLOR)
-                std::print("{}", cell.fg);
-
-            std::print("{}", cell.content);
-            if (cell.fg != RESET_COLOR || cell.bg != RESET_COLOR)
-                std::print("{}", RESET_COLOR);
+            const auto& cell = at(r, c);
+            if (color && (cell.fg != fg || cell.bg != bg)) {
+                if (fg != RESET_COLOR || bg != RESET_COLOR)
+                    out += RESET_COLOR;
+                if (cell.bg != RESET_COLOR)
+                    out += cell.bg;
+                if (cell.fg != RESET_COLOR)
+                    out += cell.fg;
+                fg = cell.fg;
+                bg = cell.bg;
+            }
+            out += cell.content;
         }
-        std::println("");
+        if (fg != RESET_COLOR || bg != RESET_COLOR)
+            out += RESET_COLOR;
+        out += '\n';
     }
 
-    std::println("");
+    out += '\n';
 
     for (std::size_t i = 0; i < game.zones.size(); ++i) {
         if (game.zones[i].type == RegionType::EMPTY)
             continue;
 
         std::string target_str = game.zones[i].target ? std::format(" (target: {})", *game.zones[i].target) : "";
-        std::println(
-            "  {}{:^3}{} : {}{}", region_colors[i], " ", RESET_COLOR, to_string(game.zones[i].type), target_str);
+        if (color) {
+            append_line(out,
+                        "  {}{:^3}{} : {}{}",
+                        REGION_COLORS[i % REGION_COLORS.size()],
+                        " ",
+                        RESET_COLOR,
+                        to_string(game.zones[i].type),
+                        target_str);
+        } else {
+            append_line(out, "  {:^3} : {}{}", zone_label(i), to_string(game.zones[i].type), target_str);
+        }
     }
+    return out;
+}
+
+void pips::print_game_solution(const pips::Game&                         game,
+                               const std::vector<pips::DominoPlacement>& solution,
+                               const std::chrono::duration<double>&      solver_time,
+                               pips::NytJsonProvider::Difficulty         difficulty,
+                               const pips::SolverStats&                  stats,
+                               bool                                      color)
+{
+    const auto text = render_game_solution(game, solution, solver_time, difficulty, stats, color);
+    std::fflush(stdout);
+    std::fwrite(text.data(), 1, text.size(), stdout);
 }
@@ -1,14 +1,31 @@
 #pragma once
 
 #include "pips_data.hpp"
+#include "solver_stats.hpp"
 
 #include <chrono>
+#include <string>
 #include <vector>
 
 namespace pips
 {
+    // Whether stdout is a terminal and NO_COLOR is unset, so ANSI colours will be seen
+    bool stdout_supports_color();
+
+    // The whole report of a solved game as one string: header, statistics, the board and the
+    // zone legend. Without colour, holes are shaded and each cell names its zone's legend label.
+    std::string render_game_solution(const pips::Game& game,
+                                     const std::vector<pips::DominoPlacement>& solution,
+                                     const std::chrono::duration<double>& solver_time,
+                                     pips::NytJsonProvider::Difficulty difficulty,
+                                     const pips::SolverStats& stats,
+                                     bool color);
+
+    // Renders the report and writes it to stdout at once
     void print_game_solution(const pips::Game& game,
                              const std::vector<pips::DominoPlacement>& solution,
                              const std::chrono::duration<double>& solver_time,
-                             pips::NytJsonProvider::Difficulty difficulty);
+                             pips::NytJsonProvider::Difficulty difficulty,
+                             const pips::SolverStats& stats,
+                             bool color);
 }
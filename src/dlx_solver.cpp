@@ -0,0 +1,517 @@
+#include "dlx_solver.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace pips {
+
+DlxSolver::DlxSolver(const Game& game) : m_game(game), m_kinds(game.tables.kinds)
+{
+    const auto& tables = game.tables;
+    const auto  cols = game.dim.cols;
+
+    std::array<std::int16_t, MAX_BOARD_CELLS> column_of;
+    column_of.fill(-1);
+
+    m_zone_states.resize(game.zones.size());
+    m_zone_columns.resize(game.zones.size());
+    for (std::uint8_t zone_id = 0; const auto& zone : game.zones) {
+        for (const auto& cell : zone.indices) {
+            const auto column = static_cast<std::uint8_t>(m_cells.size());
+            column_of[cell.row * cols + cell.col] = column;
+            m_cells.push_back(cell);
+            m_zone_of.push_back(zone_id);
+            m_zone_columns[zone_id].push_back(column);
+            m_zone_states[zone_id].size++;
+        }
+        zone_id++;
+    }
+
+    m_neighbors.assign(m_cells.size(), {-1, -1, -1, -1});
+    for (const auto& [first, second] : tables.slots) {
+        const auto a = column_of[first];
+        const auto b = column_of[second];
+        *std::ranges::find(m_neighbors[a], -1) = b;
+        *std::ranges::find(m_neighbors[b], -1) = a;
+    }
+    for (const auto& [r, c] : m_cells) {
+        m_light.push_back((r + c) % 2 == 0);
+        m_all_columns.push_back(static_cast<std::int32_t>(m_all_columns.size()));
+    }
+    m_region_stack.reserve(m_cells.size());
+    m_region_marks.assign(m_cells.size(), 0);
+
+    for (const auto& kind : m_kinds) {
+        m_kind_remaining.push_back(kind.copies);
+    }
+    for (const auto& domino : game.dominoes) {
+        m_pip_supply.halves[domino.p1]++;
+        m_pip_supply.halves[domino.p2]++;
+    }
+
+    // One row per kind, slot and orientation, minus those no zone would ever accept
+    m_kind_rows.resize(m_kinds.size());
+    for (std::uint8_t a = 0; a < m_cells.size(); ++a) {
+        const auto [r, c] = m_cells[a];
+        for (const auto& slot : tables.slots_from(r * cols + c)) {
+            const auto b = static_cast<std::uint8_t>(column_of[slot.second]);
+            for (std::uint8_t kind = 0; kind < m_kinds.size(); ++kind) {
+                for (std::size_t o = 0; o < m_kinds[kind].orientation_count; ++o) {
+                    const Row row{.kind = kind, .columns = {a, b}, .pips = m_kinds[kind].orientations[o]};
+                    if (fits(row)) {
+                        m_kind_rows[kind].push_back(static_cast<std::int32_t>(m_rows.size()));
+                        m_rows.push_back(row);
+                    }
+                }
+            }
+        }
+    }
+
+    const auto column_count = static_cast<std::int32_t>(m_cells.size());
+    m_nodes.reserve(column_count + 2 * m_rows.size());
+    for (std::int32_t column = 0; column < column_count; ++column) {
+        m_nodes.push_back({column, column, column});
+    }
+    m_sizes.assign(column_count, 0);
+    for (const auto& row : m_rows) {
+        for (const auto column : row.columns) {
+            const auto node = static_cast<std::int32_t>(m_nodes.size());
+            const auto last = m_nodes[column].up;
+            m_nodes.push_back({last, column, column});
+            m_nodes[last].down = node;
+            m_nodes[column].up = node;
+            m_sizes[column]++;
+        }
+    }
+
+    m_left.resize(column_count + 1);
+    m_right.resize(column_count + 1);
+    for (std::int32_t column = 0; column <= column_count; ++column) {
+        m_left[column] = column == 0 ? column_count : column - 1;
+        m_right[column] = column == column_count ? 0 : column + 1;
+    }
+    for (const auto& kind_rows : m_kind_rows) {
+        m_kind_sizes.push_back(static_cast<std::int32_t>(kind_rows.size()));
+    }
+    m_active.assign(column_count, true);
+    m_candidates.resize(game.dominoes.size() + 1);
+    m_hidden.assign(m_rows.size(), false);
+}
+
+SolveResult DlxSolver::solve(const SolveLimits& limits, std::stop_token stop)
+{
+    m_limiter.start(limits, std::move(stop), m_stats.nodes);
+    m_first_solution.reset();
+
+    SolutionCount result;
+    if (regions_balanced(m_all_columns)) {
+        search(1, result);
+    }
+    if (m_first_solution) {
+        return {.status = SolveStatus::SOLVED, .solution = std::move(m_first_solution)};
+    }
+    return {.status = m_limiter.status()};
+}
+
+SolutionCount DlxSolver::count_solutions(std::size_t limit, std::stop_token stop)
+{
+    m_limiter.start({}, std::move(stop), m_stats.nodes);
+    m_first_solution.reset();
+
+    SolutionCount result;
+    if (limit == 0) {
+        return result;
+    }
+
+    result.complete = !regions_balanced(m_all_columns) || !search(limit, result);
+    return result;
+}
+
+bool DlxSolver::search(std::size_t limit, SolutionCount& result)
+{
+    m_stats.nodes++;
+    if constexpr (SolverStats::ENABLED)
+        m_stats.max_depth = std::max(m_stats.max_depth, static_cast<std::uint32_t>(m_chosen.size()));
+    if (!m_limiter.admit(m_stats.nodes, m_chosen.size())) {
+        return true;
+    }
+
+    const auto root = static_cast<std::int32_t>(m_cells.size());
+    if (m_right[root] == root) {
+        std::vector<DominoPlacement> solution;
+        solution.reserve(m_chosen.size());
+        for (const auto row_id : m_chosen) {
+            const auto& row = m_rows[row_id];
+            solution.emplace_back(m_kinds[row.kind].domino,
+                                  PlacedPip{m_cells[row.columns[0]], row.pips[0]},
+                                  PlacedPip{m_cells[row.columns[1]], row.pips[1]});
+        }
+
+        result.count++;
+        if (!result.official_found && matches_official_solution(m_game, solution))
+            result.official_found = true;
+        if (!m_first_solution)
+            m_first_solution = std::move(solution);
+        return result.count >= limit;
+    }
+
+    // Knuth's S heuristic: branch on the cell with the fewest rows left
+    std::int32_t column = m_right[root];
+    for (auto c = m_right[column]; c != root && m_sizes[column] > 1; c = m_right[c]) {
+        if (m_sizes[c] < m_sizes[column])
+            column = c;
+    }
+
+    // Every domino has to go down, so a kind is a column too: dead once it has fewer rows left
+    // than copies, and a better branch than the cell when its last copy has fewer slots
+    std::int32_t kind = -1;
+    bool         dead = m_sizes[column] == 0;
+    for (std::int32_t k = 0; k < static_cast<std::int32_t>(m_kinds.size()) && !dead; ++k) {
+        if (m_kind_remaining[k] == 0)
+            continue;
+        dead = m_kind_sizes[k] < m_kind_remaining[k];
+        if (m_kind_remaining[k] == 1 && m_kind_sizes[k] < (kind < 0 ? m_sizes[column] : m_kind_sizes[kind]))
+            kind = k;
+    }
+    if (dead) {
+        if constexpr (SolverStats::ENABLED)
+            m_stats.dead_cells++;
+        return false;
+    }
+
+    const auto  depth = m_chosen.size();
+    std::size_t children = 0;
+    const auto  mark = m_trail.size();
+
+    // Rows stay put in a covered column but not in a kind's list, take a copy of the candidates
+    auto& candidates = m_candidates[depth];
+    candidates.clear();
+    if (kind < 0) {
+        cover(column);
+        for (auto node = m_nodes[column].down; node != column; node = m_nodes[node].down) {
+            candidates.push_back(row_of(node));
+        }
+    } else {
+        std::ranges::copy_if(m_kind_rows[kind], std::back_inserter(candidates), [&](std::int32_t row) {
+            return is_live(row);
+        });
+    }
+
+    for (const auto row_id : candidates) {
+        const auto& row = m_rows[row_id];
+        const auto  step = m_trail.size();
+
+        for (const auto c : row.columns) {
+            if (m_active[c])
+                cover(c);
+        }
+        place(row);
+        m_chosen.push_back(row_id);
+        children++;
+
+        bool cut = false;
+        if (!regions_balanced(row)) {
+            if constexpr (SolverStats::ENABLED)
+                m_stats.region_prunes++;
+        } else if (zones_feasible()) {
+            prune_after(row);
+            cut = search(limit, result);
+        }
+
+        m_chosen.pop_back();
+        remove(row);
+        undo_to(step);
+        if (cut) {
+            undo_to(mark);
+            if constexpr (SolverStats::ENABLED)
+                m_stats.record_branching(depth, children);
+            return true;
+        }
+        if constexpr (SolverStats::ENABLED)
+            m_stats.backtracks++;
+    }
+
+    undo_to(mark);
+    if constexpr (SolverStats::ENABLED)
+        m_stats.record_branching(depth, children);
+    return false;
+}
+
+bool DlxSolver::regions_balanced(std::span<const std::int32_t> seeds)
+{
+    m_region_stamp++;
+    for (const auto seed : seeds) {
+        if (!m_active[seed] || m_region_marks[seed] == m_region_stamp)
+            continue;
+
+        int balance = 0;
+        m_region_marks[seed] = m_region_stamp;
+        m_region_stack.push_back(seed);
+        while (!m_region_stack.empty()) {
+            const auto column = m_region_stack.back();
+            m_region_stack.pop_back();
+            balance += m_light[column] ? 1 : -1;
+            for (const auto next : m_neighbors[column]) {
+                if (next >= 0 && m_active[next] && m_region_marks[next] != m_region_stamp) {
+                    m_region_marks[next] = m_region_stamp;
+                    m_region_stack.push_back(next);
+                }
+            }
+        }
+        if (balance != 0)
+            return false;
+    }
+    return true;
+}
+
+bool DlxSolver::regions_balanced(const Row& row)
+{
+    std::array<std::int32_t, 8> seeds{};
+    std::size_t                 count = 0;
+    for (const auto column : row.columns) {
+        for (const auto next : m_neighbors[column]) {
+            if (next >= 0)
+                seeds[count++] = next;
+        }
+    }
+    return regions_balanced(std::span(seeds).first(count));
+}
+
+void DlxSolver::cover(std::int32_t column)
+{
+    m_right[m_left[column]] = m_right[column];
+    m_left[m_right[column]] = m_left[column];
+    m_active[column] = false;
+
+    // Rows through this column stay linked here but leave the column of their other cell
+    for (auto node = m_nodes[column].down; node != column; node = m_nodes[node].down) {
+        auto& n = m_nodes[partner(node)];
+        m_nodes[n.up].down = n.down;
+        m_nodes[n.down].up = n.up;
+        m_sizes[n.column]--;
+        m_kind_sizes[m_rows[row_of(node)].kind]--;
+    }
+    m_trail.push_back(-(column + 1));
+}
+
+void DlxSolver::uncover(std::int32_t column)
+{
+    for (auto node = m_nodes[column].up; node != column; node = m_nodes[node].up) {
+        const auto other = partner(node);
+        auto&      n = m_nodes[other];
+        m_nodes[n.up].down = other;
+        m_nodes[n.down].up = other;
+        m_sizes[n.column]++;
+        m_kind_sizes[m_rows[row_of(node)].kind]++;
+    }
+
+    m_active[column] = true;
+    m_right[m_left[column]] = column;
+    m_left[m_right[column]] = column;
+}
+
+void DlxSolver::hide(std::int32_t row)
+{
+    for (const auto node : {first_node(row), first_node(row) + 1}) {
+        auto& n = m_nodes[node];
+        m_nodes[n.up].down = n.down;
+        m_nodes[n.down].up = n.up;
+        m_sizes[n.column]--;
+    }
+    m_kind_sizes[m_rows[row].kind]--;
+    m_hidden[row] = true;
+    m_trail.push_back(row);
+}
+
+void DlxSolver::unhide(std::int32_t row)
+{
+    for (const auto node : {first_node(row) + 1, first_node(row)}) {
+        auto& n = m_nodes[node];
+        m_nodes[n.up].down = node;
+        m_nodes[n.down].up = node;
+        m_sizes[n.column]++;
+    }
+    m_kind_sizes[m_rows[row].kind]++;
+    m_hidden[row] = false;
+}
+
+void DlxSolver::undo_to(std::size_t mark)
+{
+    while (m_trail.size() > mark) {
+        const auto entry = m_trail.back();
+        m_trail.pop_back();
+        if (entry >= 0) {
+            unhide(entry);
+        } else {
+            uncover(-entry - 1);
+        }
+    }
+}
+
+bool DlxSolver::fits(const Row& row) const
+{
+    const auto zone_a = m_zone_of[row.columns[0]];
+    const auto zone_b = m_zone_of[row.columns[1]];
+    if (!accepts(zone_a, m_zone_states[zone_a], row.pips[0])) {
+        return false;
+    }
+    if (zone_a != zone_b) {
+        return accepts(zone_b, m_zone_states[zone_b], row.pips[1]);
+    }
+
+    // Both halves in one zone, the second is checked with the first already in
+    auto state = m_zone_states[zone_a];
+    add_pip(state, row.pips[0]);
+    return accepts(zone_a, state, row.pips[1]);
+}
+
+bool DlxSolver::accepts(std::uint8_t zone_id, const ZoneState& state, std::uint8_t pip) const
+{
+    const auto& zone = m_game.zones[zone_id];
+
+    const bool is_zone_full = state.filled + 1 == state.size;
+    const int  new_sum = state.sum + pip;
+    // Most the cells still empty after this one could add, whatever dominoes are left
+    const int headroom = (state.size - state.filled - 1) * MAX_PIP;
+
+    switch (zone.type) {
+        case RegionType::SUM:
+            return new_sum <= zone.target.value() && new_sum + headroom >= zone.target.value();
+        case RegionType::GREATER:
+            return new_sum + headroom > zone.target.value();
+        case RegionType::LESS:
+            return !is_zone_full || new_sum < zone.target.value();
+        case RegionType::EQUALS:
+            return state.filled == 0 || pip == state.first;
+        case RegionType::UNEQUAL:
+            return !(state.seen & (1u << pip));
+        case RegionType::EMPTY:
+            break;
+    }
+    return true;
+}
+
+bool DlxSolver::is_live(std::int32_t row) const
+{
+    const auto& columns = m_rows[row].columns;
+    return !m_hidden[row] && m_active[columns[0]] && m_active[columns[1]];
+}
+
+void DlxSolver::add_pip(ZoneState& state, std::uint8_t pip)
+{
+    if (state.filled++ == 0)
+        state.first = pip;
+    state.sum += pip;
+    state.seen |= static_cast<std::uint8_t>(1u << pip);
+}
+
+void DlxSolver::place(const Row& row)
+{
+    for (std::size_t i = 0; i < 2; ++i) {
+        add_pip(m_zone_states[m_zone_of[row.columns[i]]], row.pips[i]);
+        m_pip_supply.halves[row.pips[i]]--;
+    }
+    m_kind_remaining[row.kind]--;
+}
+
+void DlxSolver::remove(const Row& row)
+{
+    for (std::size_t i = 2; i-- > 0;) {
+        auto& state = m_zone_states[m_zone_of[row.columns[i]]];
+        state.filled--;
+        state.sum -= row.pips[i];
+        // Only UNEQUAL zones read `seen`, and those never hold a pip twice
+        state.seen &= static_cast<std::uint8_t>(~(1u << row.pips[i]));
+        m_pip_supply.halves[row.pips[i]]++;
+    }
+    m_kind_remaining[row.kind]++;
+}
+
+void DlxSolver::prune_after(const Row& row)
+{
+    // The last copy of a kind is gone, so is every other row that would have used it
+    if (m_kind_remaining[row.kind] == 0) {
+        for (const auto other : m_kind_rows[row.kind]) {
+            if (is_live(other))
+                hide(other);
+        }
+    }
+
+    // The zones the row landed in have new aggregates, and every zone a smaller pip supply. Rows
+    // are filtered per cell, so column sizes only count what is still possible when the next
+    // column is picked.
+    for (std::uint8_t zone_id = 0; zone_id < m_zone_states.size(); ++zone_id) {
+        const auto& state = m_zone_states[zone_id];
+        if (state.filled == state.size)
+            continue;
+
+        const bool    touched = zone_id == m_zone_of[row.columns[0]] || zone_id == m_zone_of[row.columns[1]];
+        const PipMask allowed = allowed_pips(zone_id);
+        if (!touched && allowed == ALL_PIPS)
+            continue;
+
+        for (const auto column : m_zone_columns[zone_id]) {
+            if (!m_active[column])
+                continue;
+            for (auto node = m_nodes[column].down; node != column;) {
+                const auto  next = m_nodes[node].down;
+                const auto  other = row_of(node);
+                const auto& candidate = m_rows[other];
+                const auto  pip = candidate.pips[node - first_node(other)];
+                if (!(allowed & (1u << pip)) || (touched && !fits(candidate))) {
+                    if constexpr (SolverStats::ENABLED)
+                        m_stats.record_prune(m_game.zones[zone_id].type);
+                    hide(other);
+                }
+                node = next;
+            }
+        }
+    }
+}
+
+DlxSolver::PipMask DlxSolver::allowed_pips(std::uint8_t zone_id) const
+{
+    const auto& state = m_zone_states[zone_id];
+
+    PipMask accepted = 0;
+    for (std::uint8_t pip = 0; pip <= MAX_PIP; ++pip) {
+        if (accepts(zone_id, state, pip))
+            accepted |= static_cast<PipMask>(1u << pip);
+    }
+    return m_pip_supply.completable_pips(m_game.zones[zone_id], state, accepted);
+}
+
+bool DlxSolver::zones_feasible()
+{
+    // Using a domino shrinks the supply for every zone, not just the two it landed in
+    for (std::uint8_t zone_id = 0; zone_id < m_zone_states.size(); ++zone_id) {
+        const auto& zone = m_game.zones[zone_id];
+        const auto& state = m_zone_states[zone_id];
+        if (state.filled == state.size)
+            continue;
+
+        if (!m_pip_supply.can_complete(zone, state)) {
+            if constexpr (SolverStats::ENABLED)
+                m_stats.record_prune(zone.type);
+            return false;
+        }
+    }
+    return true;
+}
+
+std::int32_t DlxSolver::first_node(std::int32_t row) const noexcept
+{
+    return static_cast<std::int32_t>(m_cells.size()) + 2 * row;
+}
+
+std::int32_t DlxSolver::row_of(std::int32_t node) const noexcept
+{
+    return (node - static_cast<std::int32_t>(m_cells.size())) / 2;
+}
+
+std::int32_t DlxSolver::partner(std::int32_t node) const noexcept
+{
+    return 2 * first_node(row_of(node)) + 1 - node;
+}
+
+}  // namespace pips
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <utility>
+#include <vector>
+#include "pips_game.hpp"
+#include "solver_engine.hpp"
+#include "solver_stats.hpp"
+
+namespace pips {
+
+// Algorithm X with dancing links. Every free cell is a primary column to cover exactly once, every
+// domino kind a column that can be covered as many times as the set holds copies of it, and every
+// (kind, pair of adjacent cells, orientation) a row. Zone constraints prune on top of the exact
+// cover: placing a row hides the rows that would now break a zone it touched.
+class DlxSolver final : public SolverEngine
+{
+public:
+    explicit DlxSolver(const Game& game);
+
+    using SolverEngine::solve;
+
+    // The links are restored before returning, every call searches from the empty board
+    [[nodiscard]] SolveResult solve(const SolveLimits& limits, std::stop_token stop = {}) override;
+    SolutionCount count_solutions(std::size_t limit, std::stop_token stop = {}) override;
+
+    [[nodiscard]] const SolverStats& stats() const noexcept override { return m_stats; }
+
+    // Rows left once the placements no zone could ever accept are dropped
+    [[nodiscard]] std::size_t rows() const noexcept { return m_rows.size(); }
+
+private:
+    using PipMask = std::uint8_t;
+    static constexpr PipMask ALL_PIPS = (1u << (MAX_PIP + 1)) - 1;
+
+    // Running aggregates of a zone, same meaning as in Solver
+    using ZoneState = ZoneFill;
+
+    struct Row
+    {
+        std::uint8_t                kind;
+        std::array<std::uint8_t, 2> columns;
+        std::array<std::uint8_t, 2> pips;
+    };
+
+    // Vertical links, the first m_cells.size() nodes are the column headers and row r owns the
+    // two nodes after them at 2r and 2r + 1
+    struct Node
+    {
+        std::int32_t up;
+        std::int32_t down;
+        std::int32_t column;
+    };
+
+    // Returns true to cut the search, once `limit` solutions are counted or on a stop request
+    bool search(std::size_t limit, SolutionCount& result);
+
+    void cover(std::int32_t column);
+    void uncover(std::int32_t column);
+    void hide(std::int32_t row);
+    void unhide(std::int32_t row);
+    // Reverts covers and hidden rows, newest first, until the trail is back to `mark` entries
+    void undo_to(std::size_t mark);
+
+    // Whether the row's pips still fit the zones of both its cells
+    bool fits(const Row& row) const;
+    bool accepts(std::uint8_t zone_id, const ZoneState& state, std::uint8_t pip) const;
+    bool is_live(std::int32_t row) const;
+
+    static void add_pip(ZoneState& state, std::uint8_t pip);
+    void        place(const Row& row);
+    void        remove(const Row& row);
+    // Hides the rows that `row` has just made illegal, by zone or by using the last copy of its kind
+    void prune_after(const Row& row);
+    // Pips an empty cell of the zone can still take, given the pips left on the unused dominoes
+    PipMask allowed_pips(std::uint8_t zone_id) const;
+    // Whether every unfinished zone can still be completed from the pips left on the unused
+    // dominoes, the same bounds Solver uses for forward checking
+    bool zones_feasible();
+    // Region pruning, as in Solver: a domino covers one light and one dark square of the
+    // checkerboard, so every region of uncovered cells reached from `seeds` must hold as many
+    // of each. The row overload seeds from the uncovered neighbours of its two cells.
+    bool regions_balanced(std::span<const std::int32_t> seeds);
+    bool regions_balanced(const Row& row);
+
+    std::int32_t first_node(std::int32_t row) const noexcept;
+    std::int32_t row_of(std::int32_t node) const noexcept;
+    // The row's node in its other column
+    std::int32_t partner(std::int32_t node) const noexcept;
+
+    const Game& m_game;
+    // Column c covers m_cells[c], a cell of zone m_zone_of[c]
+    std::vector<GridCell>     m_cells;
+    std::vector<std::uint8_t> m_zone_of;
+    std::vector<ZoneState>    m_zone_states;
+    // Columns of each zone, to find the rows a placement may have broken
+    std::vector<std::vector<std::uint8_t>> m_zone_columns;
+    // Columns of the adjacent cells, -1 past the last one, and whether the cell is a light square
+    std::vector<std::array<std::int32_t, 4>> m_neighbors;
+    std::vector<bool>                        m_light;
+    // Every column, the seeds that check the whole board. Regions are flood-filled through
+    // m_region_stack, a column belongs to the current fill once its mark equals the stamp.
+    std::vector<std::int32_t>  m_all_columns;
+    std::vector<std::int32_t>  m_region_stack;
+    std::vector<std::uint32_t> m_region_marks;
+    std::uint32_t              m_region_stamp = 0;
+
+    const std::vector<GameTables::Kind>&   m_kinds;
+    std::vector<std::uint8_t>              m_kind_remaining;
+    PipSupply                              m_pip_supply;
+    std::vector<std::vector<std::int32_t>> m_kind_rows;
+    // Live rows of each kind, the size of its column
+    std::vector<std::int32_t> m_kind_sizes;
+
+    std::vector<Row>          m_rows;
+    std::vector<Node>         m_nodes;
+    std::vector<std::int32_t> m_sizes;
+    // Horizontal ring of the uncovered column headers, the root sits at index m_cells.size()
+    std::vector<std::int32_t> m_left;
+    std::vector<std::int32_t> m_right;
+    std::vector<bool>         m_active;
+    std::vector<bool>         m_hidden;
+    // Undo log, a row index for a hidden row or -(column + 1) for a covered column
+    std::vector<std::int32_t> m_trail;
+
+    std::vector<std::int32_t>                   m_chosen;
+    // Rows to try at each depth, one level per domino and sized up front so references hold
+    std::vector<std::vector<std::int32_t>>      m_candidates;
+    std::optional<std::vector<DominoPlacement>> m_first_solution;
+    SearchLimiter                               m_limiter;
+    SolverStats                                 m_stats;
+};
+
+}  // namespace pips
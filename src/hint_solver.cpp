@@ -0,0 +1,73 @@
+#include "hint_solver.hpp"
+
+#include <algorithm>
+#include <format>
+
+namespace pips {
+
+namespace {
+
+bool same_placement(const DominoPlacement& a, const DominoPlacement& b)
+{
+    return a.placement1.cell == b.placement1.cell && a.placement1.pip == b.placement1.pip &&
+           a.placement2.cell == b.placement2.cell && a.placement2.pip == b.placement2.pip;
+}
+
+std::string rejected(std::size_t index, const DominoPlacement& placement)
+{
+    const auto& [domino, half1, half2] = placement;
+    return std::format("Placement {} ({} on {},{} and {} on {},{}) is off the board, on a covered cell, of a domino "
+                       "with no copy left or breaks a zone.",
+                       index,
+                       half1.pip,
+                       half1.cell.row,
+                       half1.cell.col,
+                       half2.pip,
+                       half2.cell.row,
+                       half2.cell.col);
+}
+
+}  // namespace
+
+HintSolver::HintSolver(const Game& game, SolverOptions options)
+{
+    if (static_cast<std::size_t>(game.dim.rows) * game.dim.cols <= CompactSolver::CAPACITY) {
+        m_solver = std::make_unique<CompactSolver>(game, options);
+    } else {
+        m_solver = std::make_unique<Solver>(game, options);
+    }
+}
+
+std::expected<SolveResult, std::string> HintSolver::solve(std::span<const DominoPlacement> fixed,
+                                                          const SolveLimits&               limits,
+                                                          std::stop_token                  stop)
+{
+    return std::visit(
+        [&](auto& solver) -> std::expected<SolveResult, std::string> {
+            // Placements shared with the last call stay down, only the ones after them are redone
+            const auto kept =
+                static_cast<std::size_t>(std::ranges::mismatch(m_fixed, fixed, same_placement).in1 - m_fixed.begin());
+            solver->pop_to(kept);
+            m_fixed.resize(kept);
+
+            for (std::size_t i = kept; i < fixed.size(); ++i) {
+                if (!solver->push(fixed[i])) {
+                    return std::unexpected(rejected(i, fixed[i]));
+                }
+                m_fixed.push_back(fixed[i]);
+            }
+
+            auto result = solver->solve(limits, std::move(stop));
+            // A solution leaves the search's dominoes laid, lift them so the next call starts from `fixed`
+            solver->pop_to(m_fixed.size());
+            return result;
+        },
+        m_solver);
+}
+
+const SolverStats& HintSolver::stats() const noexcept
+{
+    return std::visit([](const auto& solver) -> const SolverStats& { return solver->stats(); }, m_solver);
+}
+
+}  // namespace pips
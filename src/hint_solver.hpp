@@ -0,0 +1,40 @@
+#pragma once
+
+#include "solver.hpp"
+
+#include <expected>
+#include <memory>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace pips {
+
+// Solves one game again and again from boards a player has partly filled, as hints need. A single
+// solver lives across calls: its transposition table and learned nogoods carry over, and the
+// placements a call shares with the previous one stay on the board instead of being laid again.
+class HintSolver
+{
+public:
+    explicit HintSolver(const Game& game, SolverOptions options = {});
+
+    // Searches for a solution that starts with `fixed`, laid in order. A placement off the board,
+    // on a covered cell, of a domino with no copy left or breaking a zone is rejected; the zone
+    // checks are the search's own. The position is checked as a whole before searching, so a
+    // board that can no longer be completed usually comes back UNSATISFIABLE at once.
+    [[nodiscard]] std::expected<SolveResult, std::string> solve(std::span<const DominoPlacement> fixed,
+                                                                const SolveLimits&               limits = {},
+                                                                std::stop_token                  stop = {});
+
+    // Search-tree statistics accumulated over every call
+    [[nodiscard]] const SolverStats& stats() const noexcept;
+
+private:
+    std::variant<std::unique_ptr<CompactSolver>, std::unique_ptr<Solver>> m_solver;
+    // Placements pushed on the solver, a prefix of the last call's `fixed`
+    std::vector<DominoPlacement> m_fixed;
+};
+
+}  // namespace pips
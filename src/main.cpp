@@ -1,46 +1,171 @@
+#include "batch.hpp"
 #include "display.hpp"
 #include "pips_data.hpp"
-#include "solver.hpp"
+#include "puzzle_archive.hpp"
+#include "puzzle_cache.hpp"
+#include "solver_daemon.hpp"
+#include "solver_engine.hpp"
+
+#include <nlohmann/json.hpp>
 
 #include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <optional>
 #include <print>
+#include <string_view>
+#include <vector>
 
-[[nodiscard]] std::expected<void, std::string> fetch_daily_pips()
+int main(int argc, char* argv[])
 {
-    // Get current date in YYYY-MM-DD format
-    const auto now = std::chrono::system_clock::now();
-    const auto tt = std::chrono::system_clock::to_time_t(now);
-    const auto tm = *std::localtime(&tt);
-
-    const std::string date_str = std::format("{:04}-{:02}-{:02}", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
-
-    const std::string           url = "https://www.nytimes.com/svc/pips/v1/" + date_str + ".json";
-    const std::filesystem::path output_path = std::filesystem::current_path() / "data" / "pips.json";
-
-    std::filesystem::create_directories(output_path.parent_path());
-
-    const std::string cmd = std::format("curl -s -f -o \"{}\" \"{}\"", output_path.string(), url);
+    std::optional<unsigned>              threads;
+    std::optional<std::size_t>           count_limit;
+    std::chrono::milliseconds            time_limit{0};
+    std::uint64_t                        node_budget = 0;
+    std::uint64_t                        progress_interval = 0;
+    pips::EngineKind                     engine = pips::EngineKind::BACKTRACKING;
+    pips::SolverOptions                  options;
+    std::vector<std::filesystem::path>   puzzle_inputs;
+    std::optional<std::filesystem::path> stats_json;
+    std::optional<std::filesystem::path> pack_output;
+    std::optional<std::filesystem::path> socket;
+    pips::PuzzleSource                   source;
+    std::string                          date = pips::today_date();
+    bool                                 batch = false;
+    bool                                 daemon = false;
+    bool                                 color = true;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if ((arg == "--threads" || arg == "-j") && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--engine" && i + 1 < argc) {
+            const auto kind = pips::parse_engine_kind(argv[++i]);
+            if (!kind) {
+                std::println(std::cerr, "Error: Invalid engine '{}', expected backtrack, dlx or portfolio", argv[i]);
+                return 1;
+            }
+            engine = *kind;
+        } else if (arg == "--tt-mb" && i + 1 < argc) {
+            options.transposition_bytes = std::strtoull(argv[++i], nullptr, 10) << 20;
+        } else if (arg == "--timeout-ms" && i + 1 < argc) {
+            time_limit = std::chrono::milliseconds(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--max-nodes" && i + 1 < argc) {
+            node_budget = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--progress" && i + 1 < argc) {
+            progress_interval = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--no-backjump") {
+            options.backjumping = false;
+        } else if (arg == "--no-parity") {
+            options.region_pruning = false;
+        } else if (arg == "--no-assign") {
+            options.zone_assignments = false;
+        } else if (arg == "--no-color") {
+            color = false;
+        } else if (arg == "--count" && i + 1 < argc) {
+            count_limit = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--stats-json" && i + 1 < argc) {
+            stats_json = argv[++i];
+        } else if (arg == "--batch") {
+            batch = true;
+        } else if (arg == "--date" && i + 1 < argc) {
+            date = argv[++i];
+        } else if (arg == "--offline") {
+            source.offline = true;
+        } else if (arg == "--source" && i + 1 < argc) {
+            source.remote = argv[++i];
+        } else if (arg == "--daemon") {
+            daemon = true;
+        } else if (arg == "--socket" && i + 1 < argc) {
+            daemon = true;
+            socket = argv[++i];
+        } else if (arg == "--pack" && i + 1 < argc) {
+            pack_output = argv[++i];
+        } else if ((batch || pack_output) && !arg.starts_with("--")) {
+            // An unknown or incomplete option is a mistake, never a puzzle file
+            puzzle_inputs.emplace_back(arg);
+        } else {
+            std::println(std::cerr,
+                         "Usage: {} [--threads N] [--engine NAME] [--tt-mb N] [--timeout-ms N] [--max-nodes N] "
+                         "[--progress N] [--no-backjump] [--no-parity] [--no-assign] "
+                         "[--count N] [--stats-json FILE] [--no-color] [--date YYYY-MM-DD] [--offline] "
+                         "[--source URL|DIR] [--batch FILE_OR_DIR...] [--pack ARCHIVE FILE_OR_DIR...] "
+                         "[--daemon] [--socket PATH]",
+                         argv[0]);
+            std::println(std::cerr, "  --threads N        worker threads, 0 uses every hardware thread");
+            std::println(std::cerr, "  --engine NAME      backtrack (default), dlx (exact cover) or portfolio");
+            std::println(std::cerr, "  --tt-mb N          remember dead search states in an N MiB table");
+            std::println(std::cerr, "  --timeout-ms N     give up on a game after N milliseconds");
+            std::println(std::cerr, "  --max-nodes N      give up on a game after N search nodes");
+            std::println(std::cerr, "  --progress N       report the search progress every N nodes");
+            std::println(std::cerr, "  --no-backjump      backtrack chronologically, without learning nogoods");
+            std::println(std::cerr, "  --no-parity        keep placements that cut off a region dominoes cannot tile");
+            std::println(std::cerr, "  --no-assign        skip sharing the pips out among the zones before the search");
+            std::println(std::cerr, "  --count N          count solutions up to N, 2 checks that each game is unique");
+            std::println(std::cerr, "  --stats-json FILE  write the search statistics of each game as a JSON line");
+            std::println(std::cerr, "  --no-color         plain board, also the default when stdout is not a terminal");
+            std::println(std::cerr, "  --date YYYY-MM-DD  solve that day's puzzle instead of today's");
+            std::println(std::cerr, "  --offline          only use puzzles already cached in data/");
+            std::println(std::cerr, "  --source URL|DIR   fetch uncached puzzles from this base URL or local mirror");
+            std::println(std::cerr, "  --batch            solve every game of the given puzzle files or directories");
+            std::println(std::cerr, "  --pack ARCHIVE     pack the games of the given puzzle files into ARCHIVE.pips");
+            std::println(std::cerr, "  --daemon           solve the game JSON of each stdin line, answering on stdout");
+            std::println(std::cerr, "  --socket PATH      serve the daemon on a Unix socket instead of stdin");
+            return 1;
+        }
+    }
 
-    if (const int result = std::system(cmd.c_str()); result != 0) {
-        return std::unexpected(
-            std::format("Failed to download puzzle for {} (curl exited with code {}). "
-                        "Check that curl is installed.",
-                        date_str,
-                        result));
+    if (pack_output) {
+        if (puzzle_inputs.empty()) {
+            puzzle_inputs.emplace_back("data");
+        }
+        auto files = pips::collect_puzzle_files(puzzle_inputs);
+        if (!files) {
+            std::println(std::cerr, "Error: {}", files.error());
+            return 1;
+        }
+        auto packed = pips::pack_puzzle_files(*files, *pack_output);
+        if (!packed) {
+            std::println(std::cerr, "Error: {}", packed.error());
+            return 1;
+        }
+        std::println("Packed {} games into {}", *packed, pack_output->string());
+        return 0;
     }
 
-    return {};
-}
+    // The daemon solves many requests at once, one thread each, defaulting to every core
+    if (daemon) {
+        auto served = pips::run_daemon({.threads = threads.value_or(0),
+                                        .engine = engine,
+                                        .options = options,
+                                        .time_limit = time_limit,
+                                        .node_budget = node_budget,
+                                        .socket = socket});
+        if (!served) {
+            std::println(std::cerr, "Error: {}", served.error());
+            return 1;
+        }
+        return 0;
+    }
 
-int main()
-{
-    if (auto fetch_result = fetch_daily_pips(); !fetch_result) {
-        std::println(std::cerr, "Error: {}", fetch_result.error());
-        return 1;
+    // Batch mode spreads whole games over the threads, defaulting to every core
+    if (batch) {
+        if (puzzle_inputs.empty()) {
+            puzzle_inputs.emplace_back("data");
+        }
+        auto unsolved = pips::run_batch(puzzle_inputs, threads.value_or(0), engine, options, time_limit, node_budget);
+        if (!unsolved) {
+            std::println(std::cerr, "Error: {}", unsolved.error());
+            return 1;
+        }
+        return *unsolved == 0 ? 0 : 2;
     }
 
-    auto provider_or_error = pips::NytJsonProvider::create();
+    color = color && pips::stdout_supports_color();
+
+    // A cached puzzle skips the download entirely
+    auto provider_or_error = pips::load_daily_puzzle(date, source);
     if (!provider_or_error) {
         std::println(std::cerr, "Error: {}", provider_or_error.error());
         return 1;
@@ -48,21 +173,75 @@ int main()
 
     const auto& provider = *provider_or_error;
 
+    std::ofstream stats_out;
+    if (stats_json) {
+        stats_out.open(*stats_json);
+        if (!stats_out) {
+            std::println(std::cerr, "Error: cannot write {}", stats_json->string());
+            return 1;
+        }
+    }
+
     for (auto difficulty : {pips::NytJsonProvider::Difficulty::EASY,
                             pips::NytJsonProvider::Difficulty::MEDIUM,
                             pips::NytJsonProvider::Difficulty::HARD}) {
         const auto& game = provider.get_game(difficulty);
 
-        pips::Solver                        solver(game);
+        pips::SolveLimits limits{.node_budget = node_budget};
+        if (time_limit.count() > 0) {
+            limits.deadline = pips::SolveLimits::Clock::now() + time_limit;
+        }
+        if (progress_interval != 0) {
+            limits.progress_interval = progress_interval;
+            limits.on_progress = [](const pips::SolveProgress& progress) {
+                std::println(std::cerr,
+                             "  {} nodes, depth {}, {:.3f}s",
+                             progress.nodes,
+                             progress.depth,
+                             progress.elapsed.count());
+            };
+        }
+
+        const auto                          solver = pips::make_engine(engine, game, options, threads.value_or(1));
         const auto                          start_time = std::chrono::high_resolution_clock::now();
-        auto                                solution_opt = solver.solve();
+        auto                                result = solver->solve(limits);
         const auto                          end_time = std::chrono::high_resolution_clock::now();
         const std::chrono::duration<double> solver_time = end_time - start_time;
 
-        if (solution_opt) {
-            pips::print_game_solution(game, *solution_opt, solver_time, difficulty);
+        if (result.solution) {
+            pips::print_game_solution(game, *result.solution, solver_time, difficulty, solver->stats(), color);
         } else {
-            std::println("Solver could not find a solution.");
+            std::println("Solver could not find a solution ({}).", pips::to_string(result.status));
+        }
+        if (!result.configuration.empty()) {
+            std::println("Settled by: {}", result.configuration);
+        }
+
+        std::optional<pips::SolutionCount> counted;
+        if (count_limit) {
+            counted = pips::make_engine(engine, game, options)->count_solutions(*count_limit);
+            std::println("Solutions: {}{}{}{}",
+                         counted->count,
+                         counted->complete ? "" : "+",
+                         counted->unique() ? " (unique)" : "",
+                         counted->official_found ? ", official solution among them" : "");
+        }
+
+        if (stats_out.is_open()) {
+            nlohmann::json line = {{"difficulty", pips::NytJsonProvider::to_string(difficulty)},
+                                   {"solved", result.solution.has_value()},
+                                   {"status", pips::to_string(result.status)},
+                                   {"seconds", solver_time.count()},
+                                   {"stats", solver->stats()}};
+            if (!result.configuration.empty()) {
+                line["configuration"] = result.configuration;
+            }
+            if (counted) {
+                line["solutions"] = {{"count", counted->count},
+                                     {"complete", counted->complete},
+                                     {"official_found", counted->official_found}};
+            }
+            stats_out << line.dump() << '\n';
         }
     }
 
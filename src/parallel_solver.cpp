@@ -0,0 +1,274 @@
+#include "parallel_solver.hpp"
+
+#include <algorithm>
+#include <ranges>
+#include <thread>
+
+namespace pips {
+
+ParallelSolver::ParallelSolver(const Game& game, SolverOptions options, unsigned threads)
+    : m_game(game), m_options(options), m_threads(threads != 0 ? threads : std::thread::hardware_concurrency())
+{
+    m_threads = std::max(m_threads, 1u);
+    if (m_options.transposition_bytes > 0) {
+        m_transpositions = std::make_shared<TranspositionTable>(m_options.transposition_bytes);
+    }
+    for (unsigned i = 0; i < m_threads; ++i) {
+        m_queues.push_back(std::make_unique<WorkerQueue>());
+    }
+}
+
+SolveResult ParallelSolver::solve(const SolveLimits& limits, std::stop_token stop_token)
+{
+    m_stats = {};
+    if (m_threads == 1) {
+        return with_fitted_solver(m_game, m_options, m_transpositions, [&](auto& solver) {
+            auto result = solver.solve(limits, std::move(stop_token));
+            m_stats = solver.stats();
+            return result;
+        });
+    }
+
+    m_result.reset();
+    m_nodes = 0;
+    m_timed_out = false;
+    m_monitored = limits.node_budget != 0 || limits.on_progress;
+    m_worker_limits = {.deadline = limits.deadline, .progress_interval = NODE_REPORT_INTERVAL};
+    m_pending = 1;
+    m_queued = 1;
+    m_idle = 0;
+    m_queues.front()->tasks.emplace_back();
+
+    // A solution found by any worker and a stop from the caller both end the search, and wake
+    // the parked workers so they leave
+    std::stop_source   stop;
+    std::stop_callback forward_stop(stop_token, [&stop] { stop.request_stop(); });
+    std::stop_callback wake_idle(stop.get_token(), [this] { wake_idle_workers(); });
+    {
+        std::vector<std::jthread> workers;
+        workers.reserve(m_threads);
+        for (std::size_t id = 0; id < m_threads; ++id) {
+            workers.emplace_back([this, id, &stop] { run_worker(id, stop); });
+        }
+        if (m_monitored) {
+            monitor(limits, stop);
+        }
+    }
+
+    for (auto& queue : m_queues) {
+        queue->tasks.clear();
+    }
+    m_queued = 0;
+
+    if (m_result) {
+        return {.status = SolveStatus::SOLVED, .solution = std::move(m_result)};
+    }
+    if (m_timed_out) {
+        return {.status = SolveStatus::TIMED_OUT};
+    }
+    return {.status = stop_token.stop_requested() ? SolveStatus::CANCELLED : SolveStatus::UNSATISFIABLE};
+}
+
+SolutionCount ParallelSolver::count_solutions(std::size_t limit, std::stop_token stop)
+{
+    return with_fitted_solver(m_game, m_options, m_transpositions, [&](auto& solver) {
+        auto counted = solver.count_solutions(limit, std::move(stop));
+        m_stats = solver.stats();
+        return counted;
+    });
+}
+
+void ParallelSolver::run_worker(std::size_t id, std::stop_source& stop)
+{
+    with_fitted_solver(m_game, m_options, m_transpositions, [&](auto& solver) {
+        while (!stop.stop_requested()) {
+            auto task = take_task(id);
+            if (!task) {
+                if (m_pending.load() == 0)
+                    break;
+                wait_for_task(stop);
+                continue;
+            }
+
+            run_task(solver, *task, id, stop);
+            if (m_pending.fetch_sub(1) == 1) {
+                wake_monitor();
+                wake_idle_workers();
+            }
+        }
+
+        std::scoped_lock lock(m_result_mutex);
+        m_stats.merge(solver.stats());
+    });
+}
+
+template <typename BoardSolver>
+void ParallelSolver::run_task(BoardSolver& solver, const Task& task, std::size_t id, std::stop_source& stop)
+{
+    // A split task starts from the level that gave its branches away, without the branch it kept
+    const auto  depth = solver.depth();
+    const auto  prefix = task.path.size() - (task.split ? 1 : 0);
+    std::size_t pushed = 0;
+    while (pushed < prefix && solver.push(task.path[pushed])) {
+        pushed++;
+    }
+    if (pushed != prefix) {
+        solver.pop_to(depth);
+        return;
+    }
+
+    // Split while the pool runs short of work, the children go to this worker's own queue
+    // where idle workers can steal them
+    std::vector<DominoPlacement> children;
+    if (task.split) {
+        children = solver.branches_after(task.path.back());
+    } else if (m_pending.load() < m_threads * TASKS_PER_WORKER) {
+        children = solver.candidate_placements();
+    }
+
+    if (task.split || !children.empty()) {
+        // Expanding the position here visits it as surely as a search would
+        solver.count_expansion(children.size());
+        m_nodes.fetch_add(1);
+
+        std::vector<Task> subtasks;
+        subtasks.reserve(children.size());
+        for (const auto& child : children) {
+            Task subtask{.path = {task.path.begin(), task.path.begin() + static_cast<std::ptrdiff_t>(prefix)}};
+            subtask.path.push_back(child);
+            subtasks.push_back(std::move(subtask));
+        }
+        share_tasks(id, std::move(subtasks));
+    } else {
+        // Publish the node count as the search goes, and hand part of the subtree over whenever
+        // more workers are idle than tasks are queued
+        const auto    start_nodes = solver.nodes();
+        std::uint64_t published = 0;
+        auto          limits = m_worker_limits;
+        limits.on_progress = [&](const SolveProgress& progress) {
+            m_nodes.fetch_add(progress.nodes - published);
+            published = progress.nodes;
+            if (m_idle.load() > m_queued.load()) {
+                if (auto path = solver.split_search(); !path.empty()) {
+                    share_tasks(id, {Task{.path = std::move(path), .split = true}});
+                }
+            }
+        };
+
+        auto result = solver.solve(limits, stop.get_token());
+        m_nodes.fetch_add(solver.nodes() - start_nodes - published);
+        if (result.status == SolveStatus::SOLVED) {
+            std::scoped_lock lock(m_result_mutex);
+            if (!m_result) {
+                m_result = std::move(result.solution);
+                stop.request_stop();
+            }
+            wake_monitor();
+        } else if (result.status == SolveStatus::TIMED_OUT) {
+            m_timed_out = true;
+            stop.request_stop();
+            wake_monitor();
+        }
+    }
+
+    // Also lifts the dominoes a search that found a solution laid
+    solver.pop_to(depth);
+}
+
+void ParallelSolver::monitor(const SolveLimits& limits, std::stop_source& stop)
+{
+    const auto    start = SolveLimits::Clock::now();
+    const auto    interval = std::max<std::uint64_t>(limits.progress_interval, 1);
+    std::uint64_t next_progress = interval;
+
+    std::unique_lock lock(m_monitor_mutex);
+    while (!stop.stop_requested() && m_pending.load() != 0) {
+        m_monitor_wake.wait_for(lock, MONITOR_PERIOD);
+
+        const auto nodes = m_nodes.load();
+        if (limits.node_budget != 0 && nodes >= limits.node_budget) {
+            m_timed_out = true;
+            stop.request_stop();
+        } else if (limits.on_progress && nodes >= next_progress) {
+            limits.on_progress({.nodes = nodes, .depth = 0, .elapsed = SolveLimits::Clock::now() - start});
+            next_progress = nodes + interval;
+        }
+    }
+}
+
+void ParallelSolver::wake_monitor()
+{
+    if (!m_monitored)
+        return;
+    // Taking the lock orders the notification after the monitor's check or before its wait
+    {
+        std::scoped_lock lock(m_monitor_mutex);
+    }
+    m_monitor_wake.notify_all();
+}
+
+std::optional<ParallelSolver::Task> ParallelSolver::take_task(std::size_t id)
+{
+    // Own queue first, newest task at the back keeps the search depth-first
+    {
+        auto&            queue = *m_queues[id];
+        std::scoped_lock lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            auto task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            m_queued--;
+            return task;
+        }
+    }
+
+    // Steal the oldest task of another worker, it is the closest to the root and so the largest
+    for (std::size_t offset = 1; offset < m_queues.size(); ++offset) {
+        auto&            victim = *m_queues[(id + offset) % m_queues.size()];
+        std::scoped_lock lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            auto task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            m_queued--;
+            return task;
+        }
+    }
+
+    return std::nullopt;
+}
+
+void ParallelSolver::share_tasks(std::size_t id, std::vector<Task> tasks)
+{
+    if (tasks.empty())
+        return;
+
+    auto& queue = *m_queues[id];
+    m_pending.fetch_add(tasks.size());
+    {
+        std::scoped_lock lock(queue.mutex);
+        // Owners pop from the back, so push in reverse to explore in search order
+        for (auto& task : tasks | std::views::reverse) {
+            queue.tasks.push_back(std::move(task));
+        }
+        m_queued.fetch_add(tasks.size());
+    }
+    wake_idle_workers();
+}
+
+void ParallelSolver::wait_for_task(const std::stop_source& stop)
+{
+    std::unique_lock lock(m_idle_mutex);
+    m_idle++;
+    m_task_ready.wait(lock, [&] { return m_queued.load() != 0 || m_pending.load() == 0 || stop.stop_requested(); });
+    m_idle--;
+}
+
+void ParallelSolver::wake_idle_workers()
+{
+    // Taking the lock orders the notification after a worker's check or before its wait
+    {
+        std::scoped_lock lock(m_idle_mutex);
+    }
+    m_task_ready.notify_all();
+}
+
+}  // namespace pips
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "solver.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <vector>
+
+namespace pips {
+
+// Runs the Solver search on several threads. The top of the search tree is split into
+// subtrees that workers share through work-stealing queues, a worker deep in a subtree gives
+// part of it away while others sit idle, and the first worker to reach a solution cancels all
+// the others.
+class ParallelSolver final : public SolverEngine
+{
+public:
+    // `threads` of 0 uses every hardware thread
+    explicit ParallelSolver(const Game& game, SolverOptions options = {}, unsigned threads = 0);
+
+    using SolverEngine::solve;
+
+    // Every worker checks the deadline. A node budget or progress callback is served by the
+    // calling thread from the node counts workers publish every few thousand nodes, so the budget
+    // may overshoot by that much per worker and progress reports a depth of 0.
+    [[nodiscard]] SolveResult solve(const SolveLimits& limits, std::stop_token stop = {}) override;
+
+    // Counting has to walk the whole tree in order, it runs on a single Solver
+    SolutionCount count_solutions(std::size_t limit, std::stop_token stop = {}) override;
+
+    // Statistics of every worker's search, merged once solve() returns
+    [[nodiscard]] const SolverStats& stats() const noexcept override { return m_stats; }
+
+private:
+    // Placements leading from the empty board to the root of a subtree. A split task is the
+    // branches a running search gave away: those its level tries after the last placement.
+    struct Task
+    {
+        std::vector<DominoPlacement> path;
+        bool                         split = false;
+    };
+
+    struct WorkerQueue
+    {
+        std::mutex       mutex;
+        std::deque<Task> tasks;
+    };
+
+    void run_worker(std::size_t id, std::stop_source& stop);
+    // Runs on whichever solver instantiation fits the board
+    template <typename BoardSolver>
+    void                run_task(BoardSolver& solver, const Task& task, std::size_t id, std::stop_source& stop);
+    std::optional<Task> take_task(std::size_t id);
+    // Queues `tasks` on the worker's own queue and wakes the idle workers
+    void                share_tasks(std::size_t id, std::vector<Task> tasks);
+    // Parks an idle worker until a task is queued, the search is over or it is stopped
+    void                wait_for_task(const std::stop_source& stop);
+    void                wake_idle_workers();
+    // Enforces the node budget and reports progress until the workers are done
+    void                monitor(const SolveLimits& limits, std::stop_source& stop);
+    // Wakes monitor() once the search is over
+    void                wake_monitor();
+
+    // Keep splitting while fewer subtrees than this are waiting per worker
+    static constexpr std::size_t               TASKS_PER_WORKER = 8;
+    // Nodes a worker searches between publishing its count to the monitor and splitting its
+    // search for idle workers
+    static constexpr std::uint64_t             NODE_REPORT_INTERVAL = 4096;
+    // Longest the monitor sleeps, it bounds how late a budget or a cancellation is noticed
+    static constexpr std::chrono::milliseconds MONITOR_PERIOD{1};
+
+    const Game&   m_game;
+    SolverOptions m_options;
+    unsigned      m_threads;
+    // Dead states found by one worker are dead for all of them, the table is shared
+    std::shared_ptr<TranspositionTable> m_transpositions;
+
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+    // Tasks queued or running, workers leave once it drops to zero
+    std::atomic<std::size_t> m_pending = 0;
+    // Tasks queued, and the workers parked waiting for one
+    std::atomic<std::size_t> m_queued = 0;
+    std::atomic<unsigned>    m_idle = 0;
+    std::mutex               m_idle_mutex;
+    std::condition_variable  m_task_ready;
+
+    // Limits every worker's solve() runs under
+    SolveLimits m_worker_limits;
+    bool        m_monitored = false;
+    // Nodes searched by every worker, published while they search when a monitor reads them
+    std::atomic<std::uint64_t> m_nodes = 0;
+    std::atomic<bool>          m_timed_out = false;
+    std::mutex                 m_monitor_mutex;
+    std::condition_variable    m_monitor_wake;
+
+    std::mutex                                  m_result_mutex;
+    std::optional<std::vector<DominoPlacement>> m_result;
+    SolverStats                                 m_stats;
+};
+
+}  // namespace pips
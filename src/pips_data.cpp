@@ -1,9 +1,12 @@
 #include "pips_data.hpp"
 
+#include <nlohmann/json.hpp>
+
 #include <algorithm>
 #include <cstdint>
 #include <filesystem>
 #include <fstream>
+#include <limits>
 #include <string>
 
 namespace pips
@@ -11,158 +14,418 @@ namespace pips
 
 std::expected<NytJsonProvider, std::string> NytJsonProvider::create()
 {
-    NytJsonProvider provider;
-
-    auto data_file_path = std::filesystem::current_path() / "data" / "pips.json";
+    return create(std::filesystem::current_path() / "data" / "pips.json");
+}
 
-    std::ifstream file(data_file_path);
-    if (!file.is_open()) {
-        return std::unexpected("Failed to open file: " + data_file_path.string());
+class NytJsonProvider::SaxHandler final : public nlohmann::json_sax<nlohmann::json>
+{
+public:
+    explicit SaxHandler(NytJsonProvider& provider, std::array<bool, 3> wanted) : m_provider(provider), m_wanted(wanted)
+    {
     }
 
-    provider.m_json_data = nlohmann::json::parse(file, nullptr, false);
-    if (provider.m_json_data.is_discarded()) {
-        return std::unexpected("Failed to parse JSON file: " + data_file_path.string());
+    // Reads a lone game object into the provider's first game, its solution may be left out
+    explicit SaxHandler(NytJsonProvider& provider)
+        : m_provider(provider),
+          m_root(Role::GAME),
+          m_required_fields(field_bit(Role::DOMINOES) | field_bit(Role::REGIONS))
+    {
     }
 
-    if (auto result = provider.load_games_from_json(); !result) {
-        return std::unexpected(result.error());
+    // Error behind the first rejected event, the parser stops there
+    const std::string& error() const noexcept { return m_error; }
+
+    bool null() override { return scalar(); }
+    bool boolean(bool) override { return scalar(); }
+    // The parser only reports negative integers here, no pip or coordinate can be one
+    bool number_integer(number_integer_t) override { return number(std::numeric_limits<std::uint64_t>::max()); }
+    bool number_unsigned(number_unsigned_t value) override { return number(value); }
+    bool number_float(number_float_t, const string_t&) override { return scalar(); }
+    bool binary(binary_t&) override { return scalar(); }
+
+    bool string(string_t& value) override
+    {
+        switch (next_role()) {
+            case Role::TYPE:
+                m_zone.type = to_region_type(value);
+                return true;
+            case Role::SKIP:
+                return true;
+            default:
+                return scalar();
+        }
     }
 
-    return provider;
-}
-
-const Game& NytJsonProvider::get_game(Difficulty difficulty) const
-{
-    return m_games[static_cast<size_t>(difficulty)];
-}
-
-std::expected<void, std::string> NytJsonProvider::load_games_from_json()
-{
-    static constexpr std::array<const char*, 3> difficulties = {"easy", "medium", "hard"};
+    bool key(string_t& key) override
+    {
+        switch (m_frames.back()) {
+            case Role::ROOT:
+                m_key_role = Role::SKIP;
+                for (std::size_t i = 0; i < m_wanted.size(); ++i) {
+                    if (m_wanted[i] && key == to_string(static_cast<Difficulty>(i))) {
+                        m_game_index = i;
+                        m_key_role = Role::GAME;
+                    }
+                }
+                return true;
+            case Role::GAME:
+                m_key_role = key == "dominoes" ? Role::DOMINOES
+                           : key == "regions"  ? Role::REGIONS
+                           : key == "solution" ? Role::SOLUTION
+                                               : Role::SKIP;
+                return true;
+            case Role::REGION:
+                m_key_role = key == "indices" ? Role::INDICES
+                           : key == "type"    ? Role::TYPE
+                           : key == "target"  ? Role::TARGET
+                                              : Role::SKIP;
+                return true;
+            default:
+                m_key_role = Role::SKIP;
+                return true;
+        }
+    }
 
-    for (size_t i = 0; i < difficulties.size(); ++i) {
-        if (!m_json_data.contains(difficulties[i])) {
-            return std::unexpected("JSON data does not contain difficulty: " + std::string(difficulties[i]));
+    bool start_object(std::size_t) override
+    {
+        const auto role = next_role();
+        switch (role) {
+            case Role::GAME:
+                m_dominoes.clear();
+                m_zones.clear();
+                m_solution.clear();
+                m_fields_seen = 0;
+                break;
+            case Role::REGION:
+                m_zone = {};
+                m_zone_has_indices = false;
+                break;
+            case Role::ROOT:
+            case Role::SKIP:
+                break;
+            default:
+                return fail(wrong_shape(role));
         }
+        m_frames.push_back(role);
+        return true;
+    }
 
-        auto game_result = parse_game(m_json_data[difficulties[i]]);
-        if (!game_result) {
-            return std::unexpected(game_result.error());
+    bool end_object() override
+    {
+        const auto role = m_frames.back();
+        m_frames.pop_back();
+        if (role == Role::REGION) {
+            if (!m_zone_has_indices)
+                return fail(wrong_shape(Role::INDICES));
+            m_zones.push_back(std::move(m_zone));
+        } else if (role == Role::GAME) {
+            return finish_game();
         }
+        return true;
+    }
 
-        m_games[i] = std::move(*game_result);
+    bool start_array(std::size_t) override
+    {
+        const auto role = next_role();
+        switch (role) {
+            case Role::DOMINOES:
+            case Role::REGIONS:
+            case Role::SOLUTION:
+                m_fields_seen |= field_bit(role);
+                break;
+            case Role::DOMINO:
+            case Role::CELL:
+                m_number_count = 0;
+                break;
+            case Role::PLACEMENT:
+                m_cell_count = 0;
+                break;
+            case Role::INDICES:
+                m_zone_has_indices = true;
+                break;
+            case Role::SKIP:
+                break;
+            default:
+                return fail(wrong_shape(role));
+        }
+        m_frames.push_back(role);
+        return true;
     }
 
-    return {};
-}
+    bool end_array() override
+    {
+        const auto role = m_frames.back();
+        m_frames.pop_back();
+        switch (role) {
+            case Role::DOMINO:
+                if (m_number_count != 2)
+                    return fail("Invalid domino format.");
+                if (m_numbers[0] > MAX_PIP || m_numbers[1] > MAX_PIP)
+                    return fail("Domino pip value out of range.");
+                m_dominoes.emplace_back(m_numbers[0], m_numbers[1]);
+                return true;
+            case Role::CELL:
+                if (m_number_count != 2)
+                    return fail(m_frames.back() == Role::INDICES ? "Invalid index format." : "Invalid cell format.");
+                if (m_frames.back() == Role::INDICES) {
+                    m_zone.indices.emplace_back(m_numbers[0], m_numbers[1]);
+                    return true;
+                }
+                if (m_cell_count == m_cells.size())
+                    return fail("Invalid placement format.");
+                m_cells[m_cell_count++] = {m_numbers[0], m_numbers[1]};
+                return true;
+            case Role::PLACEMENT:
+                if (m_cell_count != 2)
+                    return fail("Invalid placement format.");
+                m_solution.emplace_back(m_cells[0], m_cells[1]);
+                return true;
+            default:
+                return true;
+        }
+    }
 
-std::expected<Game, std::string> NytJsonProvider::parse_game(const nlohmann::json& game_json)
-{
-    if (!game_json.is_object()) {
-        return std::unexpected("Game JSON is not an object.");
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex) override
+    {
+        return fail(ex.what());
     }
 
-    auto dominoes_result = parse_dominoes(game_json.value("dominoes", nlohmann::json()));
-    if (!dominoes_result)
-        return std::unexpected(dominoes_result.error());
+private:
+    // What a value stands for, given where it sits in the file
+    enum class Role : std::uint8_t {
+        DOMINOES,
+        REGIONS,
+        SOLUTION,
+        SKIP,
+        ROOT,
+        GAME,
+        DOMINO,
+        REGION,
+        INDICES,
+        CELL,
+        PLACEMENT,
+        TYPE,
+        TARGET,
+    };
+
+    // Object members take the role their key gave them, array elements the one their array implies
+    Role next_role() const noexcept
+    {
+        if (m_frames.empty())
+            return m_root;
+        switch (m_frames.back()) {
+            case Role::ROOT:
+            case Role::GAME:
+            case Role::REGION:
+                return m_key_role;
+            case Role::DOMINOES:
+                return Role::DOMINO;
+            case Role::REGIONS:
+                return Role::REGION;
+            case Role::INDICES:
+            case Role::PLACEMENT:
+                return Role::CELL;
+            case Role::SOLUTION:
+                return Role::PLACEMENT;
+            default:
+                return Role::SKIP;
+        }
+    }
 
-    auto zones_result = parse_zones(game_json.value("regions", nlohmann::json()));
-    if (!zones_result)
-        return std::unexpected(zones_result.error());
+    bool number(std::uint64_t value)
+    {
+        const auto role = m_frames.empty() ? Role::ROOT : m_frames.back();
+        if (role == Role::DOMINO || role == Role::CELL) {
+            if (m_number_count == m_numbers.size())
+                return fail(role == Role::DOMINO ? "Invalid domino format." : "Invalid cell format.");
+            if (value > std::numeric_limits<std::uint8_t>::max())
+                return fail("Number out of range in puzzle data.");
+            m_numbers[m_number_count++] = static_cast<std::uint8_t>(value);
+            return true;
+        }
+        if (next_role() == Role::TARGET) {
+            if (value > std::numeric_limits<std::uint8_t>::max())
+                return fail("Region target out of range.");
+            m_zone.target = static_cast<std::uint8_t>(value);
+            return true;
+        }
+        return scalar();
+    }
 
-    auto solution_result = parse_solution(game_json.value("solution", nlohmann::json()));
-    if (!solution_result)
-        return std::unexpected(solution_result.error());
+    // A null, boolean, float or string is only fine where nothing is read
+    bool scalar()
+    {
+        const auto role = next_role();
+        return role == Role::SKIP || fail(wrong_shape(role));
+    }
 
-    uint8_t max_row = 0, max_col = 0;
-    for (const auto& zone : *zones_result) {
-        for (const auto& cell : zone.indices) {
-            max_row = std::max(max_row, cell.row);
-            max_col = std::max(max_col, cell.col);
+    static std::string wrong_shape(Role role)
+    {
+        switch (role) {
+            case Role::ROOT:
+                return "Puzzle JSON is not an object.";
+            case Role::GAME:
+                return "Game JSON is not an object.";
+            case Role::DOMINOES:
+                return "Dominoes JSON is not an array.";
+            case Role::DOMINO:
+                return "Invalid domino format.";
+            case Role::REGIONS:
+                return "Regions JSON is not an array.";
+            case Role::REGION:
+                return "Region JSON is not an object.";
+            case Role::INDICES:
+                return "Indices JSON is not an array.";
+            case Role::CELL:
+                return "Invalid cell format.";
+            case Role::SOLUTION:
+                return "Solution JSON is not an array.";
+            case Role::PLACEMENT:
+                return "Invalid placement format.";
+            default:
+                return "Unexpected value in puzzle data.";
         }
     }
 
-    return Game{.dominoes = std::move(*dominoes_result),
-                .zones = std::move(*zones_result),
-                .dim = {.rows = static_cast<uint8_t>(max_row + 1), .cols = static_cast<uint8_t>(max_col + 1)},
-                .official_solution = std::move(*solution_result)};
-}
+    bool finish_game()
+    {
+        for (const auto field : {Role::DOMINOES, Role::REGIONS, Role::SOLUTION}) {
+            if ((m_required_fields & ~m_fields_seen & field_bit(field)) != 0)
+                return fail(wrong_shape(field));
+        }
 
-std::expected<std::vector<Domino>, std::string> NytJsonProvider::parse_dominoes(const nlohmann::json& dominoes_json)
-{
-    if (!dominoes_json.is_array())
-        return std::unexpected("Dominoes JSON is not an array.");
+        auto game = make_game(std::move(m_dominoes), std::move(m_zones), std::move(m_solution));
+        if (!game)
+            return fail(std::move(game.error()));
+        m_provider.m_games[m_game_index] = std::move(*game);
+        m_provider.m_loaded[m_game_index] = true;
+        return true;
+    }
 
-    std::vector<Domino> dominoes;
-    dominoes.reserve(dominoes_json.size());
-    for (const auto& domino_json : dominoes_json) {
-        if (!domino_json.is_array() || domino_json.size() != 2)
-            return std::unexpected("Invalid domino format.");
-        dominoes.emplace_back(domino_json[0].get<uint8_t>(), domino_json[1].get<uint8_t>());
+    static constexpr unsigned field_bit(Role field) noexcept { return 1u << static_cast<unsigned>(field); }
+
+    bool fail(std::string error)
+    {
+        m_error = std::move(error);
+        return false;
     }
 
-    return dominoes;
+    NytJsonProvider&    m_provider;
+    std::array<bool, 3> m_wanted{};
+    std::string         m_error;
+    // What the top-level value is, and the game fields that must be present
+    Role     m_root = Role::ROOT;
+    unsigned m_required_fields = field_bit(Role::DOMINOES) | field_bit(Role::REGIONS) | field_bit(Role::SOLUTION);
+
+    // Roles of the open objects and arrays, innermost last
+    std::vector<Role> m_frames;
+    Role              m_key_role = Role::SKIP;
+
+    // Fields of the game being read
+    std::size_t         m_game_index = 0;
+    unsigned            m_fields_seen = 0;
+    std::vector<Domino> m_dominoes;
+    std::vector<Zone>   m_zones;
+    OfficialSolution    m_solution;
+    Zone                m_zone{};
+    bool                m_zone_has_indices = false;
+
+    // Numbers of the innermost pair, and the cells of the placement being read
+    std::array<std::uint8_t, 2> m_numbers{};
+    std::size_t                 m_number_count = 0;
+    std::array<GridCell, 2>     m_cells{};
+    std::size_t                 m_cell_count = 0;
+};
+
+std::expected<NytJsonProvider, std::string> NytJsonProvider::create(const std::filesystem::path& data_file_path)
+{
+    return create(data_file_path, {Difficulty::EASY, Difficulty::MEDIUM, Difficulty::HARD});
 }
 
-std::expected<std::vector<Zone>, std::string> NytJsonProvider::parse_zones(const nlohmann::json& regions_json)
+std::expected<NytJsonProvider, std::string> NytJsonProvider::create(const std::filesystem::path&      data_file_path,
+                                                                    std::initializer_list<Difficulty> difficulties)
 {
-    if (!regions_json.is_array())
-        return std::unexpected("Regions JSON is not an array.");
-
-    std::vector<Zone> zones;
-    zones.reserve(regions_json.size());
-
-    for (const auto& region_json : regions_json) {
-        if (!region_json.is_object())
-            return std::unexpected("Region JSON is not an object.");
-
-        auto type_str = region_json.value("type", "empty");
+    NytJsonProvider provider;
 
-        auto target =
-            region_json.contains("target") ? std::optional(region_json["target"].get<uint8_t>()) : std::nullopt;
+    std::ifstream file(data_file_path, std::ios::binary);
+    if (!file.is_open()) {
+        return std::unexpected("Failed to open file: " + data_file_path.string());
+    }
 
-        auto indices_json = region_json.value("indices", nlohmann::json());
-        if (!indices_json.is_array())
-            return std::unexpected("Indices JSON is not an array.");
+    std::array<bool, 3> wanted{};
+    for (const auto difficulty : difficulties) {
+        wanted[static_cast<size_t>(difficulty)] = true;
+    }
 
-        std::vector<GridCell> indices;
-        indices.reserve(indices_json.size());
+    SaxHandler handler(provider, wanted);
+    if (!nlohmann::json::sax_parse(file, &handler)) {
+        return std::unexpected(data_file_path.string() + ": " + handler.error());
+    }
 
-        for (const auto& index_json : indices_json) {
-            if (!index_json.is_array() || index_json.size() != 2)
-                return std::unexpected("Invalid index format.");
-            indices.emplace_back(index_json[0].get<uint8_t>(), index_json[1].get<uint8_t>());
+    for (const auto difficulty : difficulties) {
+        if (!provider.has_game(difficulty)) {
+            return std::unexpected(data_file_path.string() +
+                                   ": JSON data does not contain difficulty: " + std::string(to_string(difficulty)));
         }
-        zones.emplace_back(to_region_type(type_str), target, std::move(indices));
     }
 
-    return zones;
+    return provider;
+}
+
+std::expected<Game, std::string> NytJsonProvider::parse_game(std::string_view json)
+{
+    NytJsonProvider provider;
+    SaxHandler      handler(provider);
+    if (!nlohmann::json::sax_parse(json.begin(), json.end(), &handler)) {
+        return std::unexpected(handler.error());
+    }
+    return std::move(provider.m_games[0]);
 }
 
-std::expected<NytJsonProvider::OfficialSolution, std::string> NytJsonProvider::parse_solution(
-    const nlohmann::json& solution_json)
+const Game& NytJsonProvider::get_game(Difficulty difficulty) const
 {
-    if (!solution_json.is_array())
-        return std::unexpected("Solution JSON is not an array.");
+    return m_games[static_cast<size_t>(difficulty)];
+}
 
-    OfficialSolution solution;
-    solution.reserve(solution_json.size());
+bool NytJsonProvider::has_game(Difficulty difficulty) const noexcept
+{
+    return m_loaded[static_cast<size_t>(difficulty)];
+}
 
-    for (const auto& placement_json : solution_json) {
-        if (!placement_json.is_array() || placement_json.size() != 2)
-            return std::unexpected("Invalid placement format.");
+std::string_view NytJsonProvider::to_string(Difficulty difficulty)
+{
+    static constexpr std::array<std::string_view, 3> difficulties = {"easy", "medium", "hard"};
+    return difficulties[static_cast<size_t>(difficulty)];
+}
 
-        const auto& cell1_json = placement_json[0];
-        const auto& cell2_json = placement_json[1];
-        if (!cell1_json.is_array() || cell1_json.size() != 2 || !cell2_json.is_array() || cell2_json.size() != 2) {
-            return std::unexpected("Invalid cell format.");
+std::expected<Game, std::string> NytJsonProvider::make_game(std::vector<Domino> dominoes,
+                                                            std::vector<Zone>   zones,
+                                                            OfficialSolution    official_solution)
+{
+    uint8_t max_row = 0, max_col = 0;
+    for (const auto& zone : zones) {
+        for (const auto& cell : zone.indices) {
+            max_row = std::max(max_row, cell.row);
+            max_col = std::max(max_col, cell.col);
         }
+    }
+
+    if (static_cast<size_t>(max_row + 1) * static_cast<size_t>(max_col + 1) > MAX_BOARD_CELLS) {
+        return std::unexpected("Board of " + std::to_string(max_row + 1) + "x" + std::to_string(max_col + 1) +
+                               " cells exceeds the solver limit of " + std::to_string(MAX_BOARD_CELLS) + " cells.");
+    }
 
-        solution.emplace_back(GridCell{cell1_json[0].get<uint8_t>(), cell1_json[1].get<uint8_t>()},
-                              GridCell{cell2_json[0].get<uint8_t>(), cell2_json[1].get<uint8_t>()});
+    for (std::size_t i = 0; i < zones.size(); ++i) {
+        if (needs_target(zones[i].type) && !zones[i].target)
+            return std::unexpected("Region " + std::to_string(i) + " has no target.");
     }
-    return solution;
+
+    Game game{.dominoes = std::move(dominoes),
+              .zones = std::move(zones),
+              .dim = {.rows = static_cast<uint8_t>(max_row + 1), .cols = static_cast<uint8_t>(max_col + 1)},
+              .official_solution = std::move(official_solution)};
+    game.tables = build_tables(game);
+    return game;
 }
 
 RegionType NytJsonProvider::to_region_type(std::string_view region_str)
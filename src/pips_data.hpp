@@ -2,10 +2,11 @@
 
 #include "pips_game.hpp"
 
-#include <nlohmann/json.hpp>
-
 #include <array>
 #include <expected>
+#include <filesystem>
+#include <initializer_list>
+#include <string>
 #include <string_view>
 
 namespace pips {
@@ -16,27 +17,41 @@ public:
     enum class Difficulty { EASY, MEDIUM, HARD };
 
     static std::expected<NytJsonProvider, std::string> create();
+    static std::expected<NytJsonProvider, std::string> create(const std::filesystem::path& data_file_path);
+    // Builds only the games of `difficulties`, the others are skipped while the file streams past
+    static std::expected<NytJsonProvider, std::string> create(const std::filesystem::path&        data_file_path,
+                                                              std::initializer_list<Difficulty> difficulties);
+
+    // Reads a single game object, shaped like each difficulty of the NYT JSON. Its official
+    // solution may be left out, counting then never reports it found.
+    static std::expected<Game, std::string> parse_game(std::string_view json);
 
+    // The difficulty must be one the provider was created with
     const Game& get_game(Difficulty difficulty) const;
+    bool        has_game(Difficulty difficulty) const noexcept;
+
+    // Key of the difficulty in the NYT JSON ("easy", "medium", "hard")
+    static std::string_view to_string(Difficulty difficulty);
 
 private:
-    NytJsonProvider() noexcept = default;
+    // Receives the parser's events and builds each wanted game as its fields stream past
+    class SaxHandler;
 
     // The solution is an array of domino placements,
     // where each placement is a pair of coordinate pairs
     using OfficialSolution = std::vector<std::pair<GridCell, GridCell>>;
 
-    std::expected<void, std::string> load_games_from_json();
+    NytJsonProvider() noexcept = default;
 
-    static std::expected<Game, std::string>                parse_game(const nlohmann::json& game_json);
-    static std::expected<std::vector<Domino>, std::string> parse_dominoes(const nlohmann::json& dominoes_json);
-    static std::expected<std::vector<Zone>, std::string>   parse_zones(const nlohmann::json& regions_json);
-    static std::expected<OfficialSolution, std::string>    parse_solution(const nlohmann::json& solution_json);
+    // Sizes the board from the zones and builds the lookup tables once a game's fields are read
+    static std::expected<Game, std::string> make_game(std::vector<Domino> dominoes,
+                                                      std::vector<Zone>   zones,
+                                                      OfficialSolution    official_solution);
 
     static RegionType to_region_type(std::string_view region_str);
 
-    nlohmann::json      m_json_data;
     std::array<Game, 3> m_games;
+    std::array<bool, 3> m_loaded{};
 };
 
 }  // namespace pips
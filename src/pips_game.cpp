@@ -1,9 +1,212 @@
 #include "pips_game.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <optional>
+#include <tuple>
 
 namespace pips {
 
+namespace {
+
+using PipCounts = GameTables::PipCounts;
+
+// Zones allowing more pip counts than this stay unrestricted, the search would spend more
+// scanning them than they prune
+constexpr std::size_t MAX_ZONE_ASSIGNMENTS = 64;
+// Distinct leftover supplies tracked between two zones while sharing out the halves. Past it
+// each zone keeps every count its own constraint allows.
+constexpr std::size_t MAX_LEFTOVER_SUPPLIES = std::size_t{1} << 8;
+// Largest index of the counts a zone may hold on the way to its assignments
+constexpr std::size_t MAX_ASSIGNMENT_INDEX = std::size_t{1} << 12;
+
+// Lists the pip counts that fill a zone from `supply` and meet its constraint
+class ZoneCounts
+{
+public:
+    ZoneCounts(const Zone& zone, PipCounts supply) : m_zone(zone), m_supply(supply) {}
+
+    // Every such count, nullopt once there are more than MAX_ZONE_ASSIGNMENTS
+    std::optional<std::vector<PipCounts>> list()
+    {
+        add(0, static_cast<int>(m_zone.indices.size()), 0, 0);
+        if (m_overflow)
+            return std::nullopt;
+        return std::move(m_found);
+    }
+
+private:
+    // Picks how many of the `left` cells still open take value `pip`, then moves on to the next value
+    void add(std::uint8_t pip, int left, int sum, PipCounts counts)
+    {
+        if (m_overflow)
+            return;
+        if (pip > MAX_PIP) {
+            if (left == 0 && meets_target(sum)) {
+                m_overflow = m_found.size() == MAX_ZONE_ASSIGNMENTS;
+                m_found.push_back(counts);
+            }
+            return;
+        }
+
+        const int most = std::min<int>(left, GameTables::count_of(m_supply, pip));
+        for (int count = 0; count <= most; ++count) {
+            if (m_zone.type == RegionType::EQUALS && count != 0 && count != left)
+                continue;
+            if (m_zone.type == RegionType::UNEQUAL && count > 1)
+                break;
+            // The total only grows, SUM and LESS zones stop once past their target
+            const int total = sum + count * pip;
+            if ((m_zone.type == RegionType::SUM && total > m_zone.target.value()) ||
+                (m_zone.type == RegionType::LESS && total >= m_zone.target.value()))
+                break;
+            add(pip + 1, left - count, total, counts + count * GameTables::pip_count(pip));
+        }
+    }
+
+    bool meets_target(int sum) const
+    {
+        switch (m_zone.type) {
+            case RegionType::SUM:
+                return sum == m_zone.target.value();
+            case RegionType::LESS:
+                return sum < m_zone.target.value();
+            case RegionType::GREATER:
+                return sum > m_zone.target.value();
+            case RegionType::EQUALS:
+            case RegionType::UNEQUAL:
+            case RegionType::EMPTY:
+                break;
+        }
+        return true;
+    }
+
+    const Zone&            m_zone;
+    PipCounts              m_supply;
+    std::vector<PipCounts> m_found;
+    bool                   m_overflow = false;
+};
+
+// Drops the counts of each listed zone that leave too few halves for the other listed zones,
+// unrestricted zones take whatever is left. False when no share-out fits at all.
+bool share_out(std::vector<std::vector<PipCounts>>& assignments, PipCounts supply)
+{
+    // Zones with the fewest choices go first, the leftovers multiply more slowly that way
+    std::vector<std::size_t> listed;
+    for (std::size_t zone_id = 0; zone_id < assignments.size(); ++zone_id) {
+        if (!assignments[zone_id].empty())
+            listed.push_back(zone_id);
+    }
+    std::ranges::stable_sort(listed, {}, [&](std::size_t zone_id) { return assignments[zone_id].size(); });
+
+    // leftovers[i] holds the supplies the listed zones before listed[i] can leave, sorted
+    std::vector<std::vector<PipCounts>> leftovers = {{supply}};
+    for (const auto zone_id : listed) {
+        std::vector<PipCounts> next;
+        for (const auto left : leftovers.back()) {
+            for (const auto counts : assignments[zone_id]) {
+                if (GameTables::counts_within(counts, left))
+                    next.push_back(left - counts);
+            }
+        }
+        std::ranges::sort(next);
+        next.erase(std::ranges::unique(next).begin(), next.end());
+        if (next.size() > MAX_LEFTOVER_SUPPLIES)
+            return true;
+        leftovers.push_back(std::move(next));
+    }
+
+    // Walking back, a leftover is viable when it can serve every later zone. A zone keeps the
+    // counts that lead from a reachable leftover to a viable one.
+    auto viable = std::move(leftovers.back());
+    for (std::size_t i = listed.size(); i-- > 0;) {
+        auto&                  zone_counts = assignments[listed[i]];
+        std::vector<bool>      used(zone_counts.size());
+        std::vector<PipCounts> earlier;
+        for (const auto left : leftovers[i]) {
+            bool served = false;
+            for (std::size_t j = 0; j < zone_counts.size(); ++j) {
+                if (GameTables::counts_within(zone_counts[j], left) &&
+                    std::ranges::binary_search(viable, left - zone_counts[j])) {
+                    used[j] = true;
+                    served = true;
+                }
+            }
+            if (served)
+                earlier.push_back(left);
+        }
+
+        std::size_t kept = 0;
+        for (std::size_t j = 0; j < zone_counts.size(); ++j) {
+            if (used[j])
+                zone_counts[kept++] = zone_counts[j];
+        }
+        zone_counts.resize(kept);
+        viable = std::move(earlier);
+    }
+    return !viable.empty();
+}
+
+// Indexes every count `assignments` contain with what each of them still lacks from there,
+// nullopt when the index would grow past MAX_ASSIGNMENT_INDEX
+std::optional<GameTables::ZoneAssignments> index_assignments(const std::vector<PipCounts>& assignments)
+{
+    GameTables::ZoneAssignments table;
+
+    std::size_t size = 1;
+    for (std::uint8_t pip = 0; pip <= MAX_PIP; ++pip) {
+        const auto most = std::ranges::max(assignments, {}, [&](PipCounts counts) {
+            return GameTables::count_of(counts, pip);
+        });
+        table.stride[pip] = static_cast<std::uint16_t>(size);
+        size *= GameTables::count_of(most, pip) + 1u;
+        if (size > MAX_ASSIGNMENT_INDEX)
+            return std::nullopt;
+    }
+
+    // Each assignment is within reach of every count it contains, walked like an odometer
+    std::vector<std::vector<PipCounts>> missing(size);
+    for (const auto assignment : assignments) {
+        std::array<std::uint8_t, MAX_PIP + 1> held{};
+        for (;;) {
+            std::size_t index = 0;
+            PipCounts   counts = 0;
+            for (std::uint8_t pip = 0; pip <= MAX_PIP; ++pip) {
+                index += held[pip] * table.stride[pip];
+                counts += held[pip] * GameTables::pip_count(pip);
+            }
+            missing[index].push_back(assignment - counts);
+
+            std::uint8_t pip = 0;
+            while (pip <= MAX_PIP && held[pip] == GameTables::count_of(assignment, pip)) {
+                held[pip++] = 0;
+            }
+            if (pip > MAX_PIP)
+                break;
+            held[pip]++;
+        }
+    }
+
+    for (const auto& lacking : missing) {
+        table.begin.push_back(static_cast<std::uint32_t>(table.missing.size()));
+        PipCounts most = 0;
+        for (const auto counts : lacking) {
+            table.missing.push_back(counts);
+            for (std::uint8_t pip = 0; pip <= MAX_PIP; ++pip) {
+                if (GameTables::count_of(counts, pip) > GameTables::count_of(most, pip))
+                    most += (GameTables::count_of(counts, pip) - GameTables::count_of(most, pip)) *
+                            GameTables::pip_count(pip);
+            }
+        }
+        table.most_missing.push_back(most);
+        table.next_pips.push_back(GameTables::values_in(most));
+    }
+    table.begin.push_back(static_cast<std::uint32_t>(table.missing.size()));
+    return table;
+}
+
+}  // namespace
+
 bool GridCell::is_adjacent(const GridCell& other) const noexcept
 {
     const auto dx = static_cast<int8_t>(col - other.col);
@@ -11,4 +214,110 @@ bool GridCell::is_adjacent(const GridCell& other) const noexcept
     return (dx == 0 && std::abs(dy) == 1) || (dy == 0 && std::abs(dx) == 1);
 }
 
+GameTables build_tables(const Game& game)
+{
+    const auto& [rows, cols] = game.dim;
+    const std::size_t cell_count = rows * cols;
+
+    GameTables tables;
+    tables.zone_of.assign(cell_count, GameTables::NO_ZONE);
+    for (std::uint8_t zone_id = 0; const auto& zone : game.zones) {
+        for (const auto& cell : zone.indices) {
+            tables.zone_of[cell.row * cols + cell.col] = zone_id;
+        }
+        zone_id++;
+    }
+
+    // Pairing each cell with its right and lower neighbour lists every slot once
+    tables.slot_begin.reserve(cell_count + 1);
+    for (std::size_t cell = 0; cell < cell_count; ++cell) {
+        tables.slot_begin.push_back(static_cast<std::uint16_t>(tables.slots.size()));
+        if (tables.zone_of[cell] == GameTables::NO_ZONE)
+            continue;
+        const bool has_right = cell % cols + 1 < cols;
+        if (has_right && tables.zone_of[cell + 1] != GameTables::NO_ZONE)
+            tables.slots.push_back({static_cast<std::uint8_t>(cell), static_cast<std::uint8_t>(cell + 1)});
+        if (cell + cols < cell_count && tables.zone_of[cell + cols] != GameTables::NO_ZONE)
+            tables.slots.push_back({static_cast<std::uint8_t>(cell), static_cast<std::uint8_t>(cell + cols)});
+    }
+    tables.slot_begin.push_back(static_cast<std::uint16_t>(tables.slots.size()));
+
+    for (const auto& domino : game.dominoes) {
+        const auto same_kind = [&](const GameTables::Kind& kind) {
+            const auto& [p1, p2] = kind.domino;
+            return (p1 == domino.p1 && p2 == domino.p2) || (p1 == domino.p2 && p2 == domino.p1);
+        };
+        if (const auto it = std::ranges::find_if(tables.kinds, same_kind); it != tables.kinds.end()) {
+            it->copies++;
+            continue;
+        }
+
+        GameTables::Kind kind{.domino = domino, .copies = 1};
+        kind.orientations[kind.orientation_count++] = {domino.p1, domino.p2};
+        if (domino.p1 != domino.p2)
+            kind.orientations[kind.orientation_count++] = {domino.p2, domino.p1};
+        tables.kinds.push_back(kind);
+    }
+
+    // Phase one of the search: work out the pips each zone can end up with from the halves
+    // alone, so the tiling only tries placements that keep to one of them
+    std::array<int, MAX_PIP + 1> halves{};
+    for (const auto& domino : game.dominoes) {
+        halves[domino.p1]++;
+        halves[domino.p2]++;
+    }
+    tables.zone_assignments.resize(game.zones.size());
+    if (std::ranges::all_of(halves, [](int count) { return count < 128; })) {
+        PipCounts supply = 0;
+        for (std::uint8_t pip = 0; pip <= MAX_PIP; ++pip) {
+            supply += halves[pip] * GameTables::pip_count(pip);
+        }
+        std::vector<std::vector<PipCounts>> assignments(game.zones.size());
+        for (std::size_t zone_id = 0; zone_id < game.zones.size(); ++zone_id) {
+            if (auto counts = ZoneCounts(game.zones[zone_id], supply).list()) {
+                tables.assignable = tables.assignable && !counts->empty();
+                assignments[zone_id] = std::move(*counts);
+            }
+        }
+        tables.assignable = tables.assignable && share_out(assignments, supply);
+
+        for (std::size_t zone_id = 0; zone_id < game.zones.size() && tables.assignable; ++zone_id) {
+            if (assignments[zone_id].empty())
+                continue;
+            if (auto table = index_assignments(assignments[zone_id]))
+                tables.zone_assignments[zone_id] = std::move(*table);
+        }
+    }
+
+    return tables;
+}
+
+bool matches_official_solution(const Game& game, const std::vector<DominoPlacement>& solution)
+{
+    if (game.official_solution.size() != game.dominoes.size() || solution.size() != game.dominoes.size())
+        return false;
+
+    // Each domino as (first cell, second cell, first pip, second pip) with its cells in order
+    using Laid = std::tuple<GridCell, GridCell, std::uint8_t, std::uint8_t>;
+    const auto laid = [](PlacedPip a, PlacedPip b) {
+        if (b.cell < a.cell)
+            std::swap(a, b);
+        return Laid{a.cell, b.cell, a.pip, b.pip};
+    };
+
+    std::vector<Laid> official;
+    std::vector<Laid> found;
+    official.reserve(solution.size());
+    found.reserve(solution.size());
+    for (std::size_t i = 0; i < game.dominoes.size(); ++i) {
+        const auto& [cell1, cell2] = game.official_solution[i];
+        official.push_back(laid({cell1, game.dominoes[i].p1}, {cell2, game.dominoes[i].p2}));
+        found.push_back(laid(solution[i].placement1, solution[i].placement2));
+    }
+
+    std::ranges::sort(official);
+    std::ranges::sort(found);
+    return official == found;
+}
+
 }  // namespace pips
@@ -1,12 +1,22 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <optional>
+#include <span>
 #include <utility>
 #include <vector>
 
 namespace pips {
 
+// Pips on a double-six set run from 0 to MAX_PIP
+inline constexpr std::uint8_t MAX_PIP = 6;
+
+// Largest board (rows * cols) the solver bitboards can address
+inline constexpr std::size_t MAX_BOARD_CELLS = 128;
+
 struct Domino
 {
     std::uint8_t p1;
@@ -38,6 +48,13 @@ struct DominoPlacement
 
 enum class RegionType { EMPTY, EQUALS, SUM, LESS, GREATER, UNEQUAL };
 
+// Sum, less and greater compare a zone's pips against its target, a zone of those types without one
+// cannot be solved
+[[nodiscard]] constexpr bool needs_target(RegionType type) noexcept
+{
+    return type == RegionType::SUM || type == RegionType::LESS || type == RegionType::GREATER;
+}
+
 struct Zone
 {
     RegionType                  type;
@@ -51,12 +68,214 @@ struct BoardDimensions
     std::uint8_t cols;
 };
 
+// Lookup tables derived once per Game, so engines and the display index flat arrays instead of
+// rebuilding them. Cells are addressed by their flat index, row * cols + col.
+struct GameTables
+{
+    static constexpr std::uint8_t NO_ZONE = 0xff;
+
+    // Two adjacent zone cells, `first` is the lower index
+    struct Slot
+    {
+        std::uint8_t first;
+        std::uint8_t second;
+    };
+
+    // A distinct domino, its number of copies and the pips it can put on (first, second) of a
+    // slot. A double reads the same both ways round and has a single orientation.
+    struct Kind
+    {
+        Domino                                     domino;
+        std::uint8_t                               copies = 0;
+        std::uint8_t                               orientation_count = 0;
+        std::array<std::array<std::uint8_t, 2>, 2> orientations{};
+    };
+
+    // How many pips of each value a set of cells holds, value v in byte v
+    using PipCounts = std::uint64_t;
+
+    [[nodiscard]] static constexpr PipCounts pip_count(std::uint8_t pip) noexcept { return PipCounts{1} << (8 * pip); }
+    [[nodiscard]] static constexpr std::uint8_t count_of(PipCounts counts, std::uint8_t pip) noexcept
+    {
+        return static_cast<std::uint8_t>(counts >> (8 * pip));
+    }
+    // Whether `counts` holds no more pips of any value than `bound`, both below 128 per value
+    [[nodiscard]] static constexpr bool counts_within(PipCounts counts, PipCounts bound) noexcept
+    {
+        constexpr PipCounts HIGH_BITS = 0x8080808080808080ull;
+        return (((bound | HIGH_BITS) - counts) & HIGH_BITS) == HIGH_BITS;
+    }
+    // The values with a non-zero count, bit v for value v
+    [[nodiscard]] static constexpr std::uint8_t values_in(PipCounts counts) noexcept
+    {
+        std::uint8_t values = 0;
+        for (std::uint8_t pip = 0; pip <= MAX_PIP; ++pip) {
+            if (count_of(counts, pip) != 0)
+                values |= static_cast<std::uint8_t>(1u << pip);
+        }
+        return values;
+    }
+
+    // The pip counts a zone can hold on the way to one of its assignments, indexed by the counts
+    // it holds so far: a pip of value v adds stride[v]. Entries begin[i] to begin[i + 1] of
+    // `missing` are what each assignment within reach of index i still lacks, most_missing[i]
+    // the most of each value any of them lacks and next_pips[i] the values they lack at all.
+    struct ZoneAssignments
+    {
+        std::array<std::uint16_t, MAX_PIP + 1> stride{};
+        std::vector<std::uint32_t>             begin;
+        std::vector<PipCounts>                 missing;
+        std::vector<PipCounts>                 most_missing;
+        std::vector<std::uint8_t>              next_pips;
+
+        // False for a zone left unrestricted
+        [[nodiscard]] bool restricts() const noexcept { return !next_pips.empty(); }
+    };
+
+    // Dense zone id of every cell, NO_ZONE for a hole
+    std::vector<std::uint8_t> zone_of;
+    // Every slot grouped by first cell, cell i's run from slot_begin[i] to slot_begin[i + 1]
+    std::vector<Slot>          slots;
+    std::vector<std::uint16_t> slot_begin;
+    // Copies of the same domino are interchangeable, kinds are kept in order of first appearance
+    std::vector<Kind> kinds;
+    // The assignments of each zone: the pip counts it can hold in some share-out of the dominoes'
+    // halves that meets every zone's constraint, worked out before any domino is laid. A zone
+    // with too many is left unrestricted. `assignable` is false when no share-out exists at all.
+    std::vector<ZoneAssignments> zone_assignments;
+    bool                         assignable = true;
+
+    [[nodiscard]] std::span<const Slot> slots_from(std::size_t cell) const noexcept
+    {
+        return std::span(slots).subspan(slot_begin[cell], slot_begin[cell + 1] - slot_begin[cell]);
+    }
+};
+
+// Pips laid in a zone so far, what the forward checks of both engines read
+struct ZoneFill
+{
+    std::uint8_t  size = 0;
+    std::uint8_t  filled = 0;
+    std::uint16_t sum = 0;
+    // Bit v is set while a pip of value v sits in the zone
+    std::uint8_t seen = 0;
+    // Pip of the first cell filled, all others must match it in an EQUALS zone
+    std::uint8_t first = 0;
+};
+
+// Halves of each pip value left on the unused dominoes, a double counts twice. Forward checking
+// bounds what the empty cells of a zone can still receive by it.
+struct PipSupply
+{
+    std::array<std::uint8_t, MAX_PIP + 1> halves{};
+
+    // Smallest and largest total of `count` pips drawn from the supply
+    [[nodiscard]] std::pair<int, int> bounds(int count) const noexcept
+    {
+        int low = 0;
+        for (int pip = 0, left = count; pip <= MAX_PIP && left > 0; ++pip) {
+            const int take = std::min<int>(left, halves[pip]);
+            low += take * pip;
+            left -= take;
+        }
+
+        int high = 0;
+        for (int pip = MAX_PIP, left = count; pip >= 0 && left > 0; --pip) {
+            const int take = std::min<int>(left, halves[pip]);
+            high += take * pip;
+            left -= take;
+        }
+
+        return {low, high};
+    }
+
+    // Whether the supply can still fill the zone's empty cells to meet its constraint
+    [[nodiscard]] bool can_complete(const Zone& zone, const ZoneFill& fill) const
+    {
+        const int empty = fill.size - fill.filled;
+        switch (zone.type) {
+            case RegionType::SUM: {
+                const auto [low, high] = bounds(empty);
+                return fill.sum + low <= zone.target.value() && fill.sum + high >= zone.target.value();
+            }
+            case RegionType::LESS:
+                return fill.sum + bounds(empty).first < zone.target.value();
+            case RegionType::GREATER:
+                return fill.sum + bounds(empty).second > zone.target.value();
+            case RegionType::EQUALS:
+                if (fill.filled > 0)
+                    return halves[fill.first] >= empty;
+                return std::ranges::any_of(halves, [&](std::uint8_t supply) { return supply >= empty; });
+            case RegionType::UNEQUAL: {
+                int distinct = 0;
+                for (std::uint8_t pip = 0; pip <= MAX_PIP; ++pip) {
+                    if (halves[pip] > 0 && !(fill.seen & (1u << pip)))
+                        distinct++;
+                }
+                return distinct >= empty;
+            }
+            case RegionType::EMPTY:
+                break;
+        }
+        return true;
+    }
+
+    // The pips of `candidates` an empty cell of the zone may take with the supply still able to
+    // complete its other empty cells around it. The bounds on those cells ignore that the pip
+    // itself is taken, which only loosens them.
+    [[nodiscard]] std::uint8_t completable_pips(const Zone& zone, const ZoneFill& fill, std::uint8_t candidates) const
+    {
+        const int rest = fill.size - fill.filled - 1;
+        const auto [rest_min, rest_max] = bounds(rest);
+
+        std::uint8_t completable = 0;
+        for (std::uint8_t pip = 0; pip <= MAX_PIP; ++pip) {
+            if (!(candidates & (1u << pip)) || halves[pip] == 0)
+                continue;
+
+            const int low = fill.sum + pip + rest_min;
+            const int high = fill.sum + pip + rest_max;
+
+            bool fits = true;
+            switch (zone.type) {
+                case RegionType::SUM:
+                    fits = low <= zone.target.value() && high >= zone.target.value();
+                    break;
+                case RegionType::LESS:
+                    fits = low < zone.target.value();
+                    break;
+                case RegionType::GREATER:
+                    fits = high > zone.target.value();
+                    break;
+                case RegionType::EQUALS:
+                    fits = halves[pip] > rest;
+                    break;
+                case RegionType::UNEQUAL:
+                case RegionType::EMPTY:
+                    break;
+            }
+
+            if (fits)
+                completable |= static_cast<std::uint8_t>(1u << pip);
+        }
+        return completable;
+    }
+};
+
 struct Game
 {
     std::vector<Domino>                        dominoes;
     std::vector<Zone>                          zones;
     BoardDimensions                            dim;
     std::vector<std::pair<GridCell, GridCell>> official_solution;
+    GameTables                                 tables;
 };
 
+// Builds the tables of `game` from its dominoes, zones and dimensions
+[[nodiscard]] GameTables build_tables(const Game& game);
+
+// Whether `solution` lays every domino where Game::official_solution puts it. Copies of the same
+// domino are interchangeable, so only the cell pairs and the pip on each cell are compared.
+[[nodiscard]] bool matches_official_solution(const Game& game, const std::vector<DominoPlacement>& solution);
+
 }  // namespace pips
@@ -0,0 +1,167 @@
+#include "portfolio_solver.hpp"
+
+#include "solver.hpp"
+
+#include <algorithm>
+#include <format>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace pips {
+
+namespace {
+
+// Step between the seeds of a member's restarts, far from the small seeds the next members start at
+constexpr std::uint64_t SEED_STRIDE = 0x9e3779b97f4a7c15ull;
+
+// Term i of the Luby sequence, from 1: 1, 1, 2, 1, 1, 2, 4, 1, 1, 2, ...
+std::uint64_t luby(std::uint64_t i)
+{
+    for (unsigned k = 1;; ++k) {
+        const std::uint64_t end = (std::uint64_t{1} << k) - 1;
+        if (i == end)
+            return std::uint64_t{1} << (k - 1);
+        if (i < end)
+            return luby(i - (end >> 1));
+    }
+}
+
+}  // namespace
+
+std::vector<PortfolioSolver::Member> PortfolioSolver::default_members(SolverOptions options, unsigned threads)
+{
+    auto row_major = options;
+    row_major.branching = BranchingHeuristic::ROW_MAJOR;
+
+    std::vector<Member> members = {
+        {.name = "most-constrained", .options = options},
+        {.name = "row-major", .options = row_major},
+        {.name = "dlx", .engine = EngineKind::DANCING_LINKS},
+    };
+
+    threads = threads != 0 ? threads : std::thread::hardware_concurrency();
+    for (std::uint64_t seed = 1; members.size() < threads; ++seed) {
+        auto randomized = options;
+        randomized.branching = BranchingHeuristic::MOST_CONSTRAINED;
+        randomized.seed = seed;
+        members.push_back(
+            {.name = std::format("restarts-{}", seed), .options = randomized, .restart_nodes = DEFAULT_RESTART_NODES});
+    }
+    return members;
+}
+
+PortfolioSolver::PortfolioSolver(const Game& game, SolverOptions options, unsigned threads)
+    : PortfolioSolver(game, default_members(options, threads))
+{
+}
+
+PortfolioSolver::PortfolioSolver(const Game& game, std::vector<Member> members)
+    : m_game(game), m_members(std::move(members))
+{
+    std::size_t table_bytes = 0;
+    for (const auto& member : m_members) {
+        if (member.engine == EngineKind::BACKTRACKING)
+            table_bytes = std::max(table_bytes, member.options.transposition_bytes);
+    }
+    if (table_bytes > 0) {
+        m_transpositions = std::make_shared<TranspositionTable>(table_bytes);
+    }
+}
+
+SolveResult PortfolioSolver::solve(const SolveLimits& limits, std::stop_token stop_token)
+{
+    // Members call back from their own threads, progress would arrive from all of them at once
+    auto member_limits = limits;
+    member_limits.on_progress = nullptr;
+
+    // The winner and a stop from the caller both end the race
+    std::stop_source   stop;
+    std::stop_callback forward_stop(stop_token, [&stop] { stop.request_stop(); });
+
+    std::mutex                 result_mutex;
+    std::optional<std::size_t> winner;
+    SolveResult                result;
+    std::vector<SolverStats>   member_stats(m_members.size());
+    {
+        std::vector<std::jthread> racers;
+        racers.reserve(m_members.size());
+        for (std::size_t i = 0; i < m_members.size(); ++i) {
+            racers.emplace_back([&, i] {
+                auto outcome = run_member(m_members[i], member_limits, stop.get_token(), member_stats[i]);
+                if (outcome.status != SolveStatus::SOLVED && outcome.status != SolveStatus::UNSATISFIABLE)
+                    return;
+
+                std::scoped_lock lock(result_mutex);
+                if (!winner) {
+                    winner = i;
+                    result = std::move(outcome);
+                    stop.request_stop();
+                }
+            });
+        }
+    }
+
+    if (winner) {
+        m_stats = std::move(member_stats[*winner]);
+        result.configuration = m_members[*winner].name;
+        return result;
+    }
+
+    m_stats = {};
+    for (const auto& stats : member_stats) {
+        m_stats.merge(stats);
+    }
+    return {.status = stop_token.stop_requested() ? SolveStatus::CANCELLED : SolveStatus::TIMED_OUT};
+}
+
+SolveResult PortfolioSolver::run_member(const Member&      member,
+                                        const SolveLimits& limits,
+                                        std::stop_token    stop,
+                                        SolverStats&       stats)
+{
+    // Dancing links has no order a seed could change, a restart would repeat the same search
+    if (member.engine != EngineKind::BACKTRACKING) {
+        const auto engine = make_engine(member.engine, m_game, member.options);
+        auto       result = engine->solve(limits, std::move(stop));
+        stats = engine->stats();
+        return result;
+    }
+
+    auto transpositions = member.options.transposition_bytes > 0 ? m_transpositions : nullptr;
+    return with_fitted_solver(m_game, member.options, std::move(transpositions), [&](auto& solver) {
+        auto seed = member.options.seed;
+        for (std::uint64_t run = 1;; ++run) {
+            auto run_limits = limits;
+            if (member.restart_nodes != 0) {
+                const auto restart_budget = member.restart_nodes * luby(run);
+                run_limits.node_budget = limits.node_budget != 0
+                                             ? std::min(restart_budget, limits.node_budget - solver.nodes())
+                                             : restart_budget;
+            }
+
+            auto result = solver.solve(run_limits, stop);
+
+            // A run that only used up its restart budget starts over with the next seed
+            const bool out_of_limits = (limits.deadline && SolveLimits::Clock::now() >= *limits.deadline) ||
+                                       (limits.node_budget != 0 && solver.nodes() >= limits.node_budget);
+            if (member.restart_nodes == 0 || result.status != SolveStatus::TIMED_OUT || out_of_limits) {
+                stats = solver.stats();
+                return result;
+            }
+            seed += SEED_STRIDE;
+            solver.reseed(seed);
+        }
+    });
+}
+
+SolutionCount PortfolioSolver::count_solutions(std::size_t limit, std::stop_token stop)
+{
+    const auto& member = m_members.front();
+    const auto  engine = make_engine(member.engine, m_game, member.options);
+    auto        counted = engine->count_solutions(limit, std::move(stop));
+    m_stats = engine->stats();
+    return counted;
+}
+
+}  // namespace pips
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "solver_engine.hpp"
+#include "transposition_table.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+namespace pips {
+
+// Races several search configurations on the same game, one thread each. No branching order is
+// best on every board, so the first configuration to settle the game cancels the others, and
+// SolveResult::configuration names it.
+class PortfolioSolver final : public SolverEngine
+{
+public:
+    // One configuration of the race
+    struct Member
+    {
+        std::string   name;
+        EngineKind    engine = EngineKind::BACKTRACKING;
+        SolverOptions options;
+        // Restart with a new seed after restart_nodes times the next term of the Luby sequence
+        // (1, 1, 2, 1, 1, 2, 4, ...) nodes, 0 searches once to the end. Only backtracking members
+        // restart, they keep their solver and its learned dead states from one run to the next.
+        std::uint64_t restart_nodes = 0;
+    };
+
+    // Most-constrained and row-major backtracking tuned by `options`, dancing links, then
+    // randomized most-constrained searches with restarts until there is one member per thread.
+    // `threads` of 0 uses every hardware thread, the three fixed members always run.
+    [[nodiscard]] static std::vector<Member> default_members(SolverOptions options = {}, unsigned threads = 0);
+
+    explicit PortfolioSolver(const Game& game, SolverOptions options = {}, unsigned threads = 0);
+    // `members` must not be empty. The backtracking members asking for a transposition table share
+    // one, as large as the largest SolverOptions::transposition_bytes among them.
+    PortfolioSolver(const Game& game, std::vector<Member> members);
+
+    using SolverEngine::solve;
+
+    // A solution or a proof that there is none settles the race. The deadline and node budget
+    // bound each member on its own, and progress is not reported.
+    [[nodiscard]] SolveResult solve(const SolveLimits& limits, std::stop_token stop = {}) override;
+
+    // Counting has to walk the whole tree whatever the order, it runs the first member alone
+    SolutionCount count_solutions(std::size_t limit, std::stop_token stop = {}) override;
+
+    // Statistics of the winning member, or of every member when none won
+    [[nodiscard]] const SolverStats& stats() const noexcept override { return m_stats; }
+
+private:
+    // Runs one member to its end, restarting it as configured
+    SolveResult run_member(const Member& member, const SolveLimits& limits, std::stop_token stop, SolverStats& stats);
+
+    // Smallest restart budget of the default randomized members
+    static constexpr std::uint64_t DEFAULT_RESTART_NODES = 256;
+
+    const Game&         m_game;
+    std::vector<Member> m_members;
+    // Dead states do not depend on the search order, every member can reuse the others' finds
+    std::shared_ptr<TranspositionTable> m_transpositions;
+    SolverStats                         m_stats;
+};
+
+}  // namespace pips
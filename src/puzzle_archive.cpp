@@ -0,0 +1,405 @@
+#include "puzzle_archive.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <tuple>
+#include <type_traits>
+
+namespace pips {
+
+namespace {
+
+constexpr std::array<char, 8> MAGIC = {'P', 'I', 'P', 'S', 'A', 'R', 'C', 'H'};
+constexpr std::uint32_t       VERSION = 1;
+// Records start on this boundary so their uint16 fields stay aligned
+constexpr std::size_t RECORD_ALIGNMENT = 4;
+
+struct Header
+{
+    std::array<char, 8> magic;
+    std::uint32_t       version;
+    std::uint32_t       game_count;
+};
+
+struct IndexEntry
+{
+    std::array<char, PuzzleArchive::MAX_NAME_LENGTH + 1> name;
+    std::uint8_t                                         difficulty;
+    std::array<std::uint8_t, 3>                          reserved;
+    std::uint32_t                                        offset;
+    std::uint32_t                                        size;
+};
+
+// Followed by the dominoes, the zones, every zone's cells back to back, then the solution
+struct RecordHeader
+{
+    BoardDimensions dim;
+    std::uint8_t    domino_count;
+    std::uint8_t    zone_count;
+    std::uint16_t   cell_count;
+    std::uint16_t   solution_count;
+};
+
+struct ZoneRecord
+{
+    std::uint8_t  type;
+    std::uint8_t  has_target;
+    std::uint8_t  target;
+    std::uint8_t  reserved;
+    // One past the zone's last cell in the record's cell array
+    std::uint16_t cell_end;
+};
+
+// Views cast the mapped bytes to these directly
+static_assert(std::is_trivially_copyable_v<Domino> && alignof(Domino) == 1 && sizeof(Domino) == 2);
+static_assert(std::is_trivially_copyable_v<GridCell> && alignof(GridCell) == 1 && sizeof(GridCell) == 2);
+static_assert(std::is_trivially_copyable_v<PuzzleArchive::Placement> && sizeof(PuzzleArchive::Placement) == 4);
+static_assert(sizeof(Header) % RECORD_ALIGNMENT == 0 && sizeof(IndexEntry) % RECORD_ALIGNMENT == 0);
+
+template <typename T>
+T read(const std::byte* data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+template <typename T>
+void append(std::vector<std::byte>& out, const T& value)
+{
+    const auto* bytes = reinterpret_cast<const std::byte*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+std::span<const T> cast_span(const std::byte* data, std::size_t count)
+{
+    return {reinterpret_cast<const T*>(data), count};
+}
+
+std::size_t record_size(const RecordHeader& header)
+{
+    return sizeof(RecordHeader) + header.domino_count * sizeof(Domino) + header.zone_count * sizeof(ZoneRecord) +
+           header.cell_count * sizeof(GridCell) + header.solution_count * sizeof(PuzzleArchive::Placement);
+}
+
+std::vector<std::byte> encode_record(const Game& game)
+{
+    std::vector<std::byte> out;
+
+    std::size_t cell_count = 0;
+    for (const auto& zone : game.zones) {
+        cell_count += zone.indices.size();
+    }
+    append(out,
+           RecordHeader{.dim = game.dim,
+                        .domino_count = static_cast<std::uint8_t>(game.dominoes.size()),
+                        .zone_count = static_cast<std::uint8_t>(game.zones.size()),
+                        .cell_count = static_cast<std::uint16_t>(cell_count),
+                        .solution_count = static_cast<std::uint16_t>(game.official_solution.size())});
+
+    for (const auto& domino : game.dominoes) {
+        append(out, domino);
+    }
+    std::uint16_t cell_end = 0;
+    for (const auto& zone : game.zones) {
+        cell_end += static_cast<std::uint16_t>(zone.indices.size());
+        append(out,
+               ZoneRecord{.type = static_cast<std::uint8_t>(zone.type),
+                          .has_target = zone.target.has_value(),
+                          .target = zone.target.value_or(0),
+                          .cell_end = cell_end});
+    }
+    for (const auto& zone : game.zones) {
+        for (const auto& cell : zone.indices) {
+            append(out, cell);
+        }
+    }
+    for (const auto& [first, second] : game.official_solution) {
+        append(out, PuzzleArchive::Placement{first, second});
+    }
+    return out;
+}
+
+// Checks one record against the same limits the JSON loader enforces, so its games are safe to solve
+std::expected<void, std::string> check_record(const std::byte* data, std::size_t size)
+{
+    if (size < sizeof(RecordHeader))
+        return std::unexpected("truncated record");
+    const auto header = read<RecordHeader>(data);
+    if (record_size(header) != size)
+        return std::unexpected("record size does not match its contents");
+
+    const auto [rows, cols] = header.dim;
+    if (rows == 0 || cols == 0 || static_cast<std::size_t>(rows) * cols > MAX_BOARD_CELLS)
+        return std::unexpected("board dimensions out of range");
+    if (header.zone_count >= GameTables::NO_ZONE)
+        return std::unexpected("too many zones");
+
+    const auto* cursor = data + sizeof(RecordHeader);
+    for (const auto& domino : cast_span<Domino>(cursor, header.domino_count)) {
+        if (domino.p1 > MAX_PIP || domino.p2 > MAX_PIP)
+            return std::unexpected("domino pip out of range");
+    }
+    cursor += header.domino_count * sizeof(Domino);
+
+    std::uint16_t previous_end = 0;
+    for (std::size_t i = 0; i < header.zone_count; ++i) {
+        const auto zone = read<ZoneRecord>(cursor + i * sizeof(ZoneRecord));
+        if (zone.type > static_cast<std::uint8_t>(RegionType::UNEQUAL) || zone.cell_end < previous_end ||
+            zone.cell_end > header.cell_count)
+            return std::unexpected("malformed zone");
+        if (needs_target(static_cast<RegionType>(zone.type)) && zone.has_target == 0)
+            return std::unexpected("zone without a target");
+        previous_end = zone.cell_end;
+    }
+    if (previous_end != header.cell_count)
+        return std::unexpected("zone cells do not cover the cell array");
+    cursor += header.zone_count * sizeof(ZoneRecord);
+
+    const auto in_board = [&](const GridCell& cell) { return cell.row < rows && cell.col < cols; };
+    if (!std::ranges::all_of(cast_span<GridCell>(cursor, header.cell_count), in_board))
+        return std::unexpected("zone cell outside the board");
+    cursor += header.cell_count * sizeof(GridCell);
+
+    for (const auto& [first, second] : cast_span<PuzzleArchive::Placement>(cursor, header.solution_count)) {
+        if (!in_board(first) || !in_board(second))
+            return std::unexpected("solution cell outside the board");
+    }
+    return {};
+}
+
+}  // namespace
+
+PuzzleArchive::ZoneView PuzzleArchive::GameView::zone(std::size_t index) const noexcept
+{
+    const auto record = read<ZoneRecord>(m_zones + index * sizeof(ZoneRecord));
+    const auto begin = index == 0 ? 0 : read<ZoneRecord>(m_zones + (index - 1) * sizeof(ZoneRecord)).cell_end;
+    return {.type = static_cast<RegionType>(record.type),
+            .target = record.has_target ? std::optional(record.target) : std::nullopt,
+            .indices = m_cells.subspan(begin, record.cell_end - begin)};
+}
+
+Game PuzzleArchive::GameView::to_game() const
+{
+    Game game{.dominoes = {m_dominoes.begin(), m_dominoes.end()}, .dim = m_dim};
+    game.zones.reserve(m_zone_count);
+    for (std::size_t i = 0; i < m_zone_count; ++i) {
+        const auto zone = this->zone(i);
+        game.zones.push_back({.type = zone.type,
+                              .target = zone.target,
+                              .indices = {zone.indices.begin(), zone.indices.end()}});
+    }
+    game.official_solution.reserve(m_solution.size());
+    for (const auto& [first, second] : m_solution) {
+        game.official_solution.emplace_back(first, second);
+    }
+    game.tables = build_tables(game);
+    return game;
+}
+
+std::expected<PuzzleArchive, std::string> PuzzleArchive::open(const std::filesystem::path& path)
+{
+    const auto fail = [&](std::string_view reason) {
+        return std::unexpected(path.string() + ": " + std::string(reason));
+    };
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return fail(std::strerror(errno));
+
+    struct stat file_stat{};
+    if (::fstat(fd, &file_stat) != 0) {
+        ::close(fd);
+        return fail(std::strerror(errno));
+    }
+
+    PuzzleArchive archive;
+    archive.m_size = static_cast<std::size_t>(file_stat.st_size);
+    if (archive.m_size < sizeof(Header)) {
+        ::close(fd);
+        return fail("not a puzzle archive");
+    }
+    void* mapping = ::mmap(nullptr, archive.m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        return fail(std::strerror(errno));
+    archive.m_data = static_cast<const std::byte*>(mapping);
+
+    const auto header = read<Header>(archive.m_data);
+    if (header.magic != MAGIC)
+        return fail("not a puzzle archive");
+    if (header.version != VERSION)
+        return fail("unsupported archive version " + std::to_string(header.version));
+    if (header.game_count > (archive.m_size - sizeof(Header)) / sizeof(IndexEntry))
+        return fail("truncated index");
+
+    archive.m_games.reserve(header.game_count);
+    const auto* index = archive.m_data + sizeof(Header);
+    for (std::size_t i = 0; i < header.game_count; ++i) {
+        const auto* entry_bytes = index + i * sizeof(IndexEntry);
+        const auto  entry = read<IndexEntry>(entry_bytes);
+        if (entry.name.back() != '\0' || entry.difficulty > static_cast<std::uint8_t>(Difficulty::HARD))
+            return fail("malformed index entry " + std::to_string(i));
+        if (entry.offset % RECORD_ALIGNMENT != 0 || entry.offset > archive.m_size ||
+            entry.size > archive.m_size - entry.offset)
+            return fail("index entry " + std::to_string(i) + " points outside the archive");
+
+        const auto* record = archive.m_data + entry.offset;
+        if (auto checked = check_record(record, entry.size); !checked)
+            return fail(std::string(entry.name.data()) + ": " + checked.error());
+
+        const auto record_header = read<RecordHeader>(record);
+        const auto* cursor = record + sizeof(RecordHeader);
+
+        GameView view;
+        view.m_name = reinterpret_cast<const char*>(entry_bytes + offsetof(IndexEntry, name));
+        view.m_difficulty = static_cast<Difficulty>(entry.difficulty);
+        view.m_dim = record_header.dim;
+        view.m_dominoes = cast_span<Domino>(cursor, record_header.domino_count);
+        cursor += record_header.domino_count * sizeof(Domino);
+        view.m_zones = cursor;
+        view.m_zone_count = record_header.zone_count;
+        cursor += record_header.zone_count * sizeof(ZoneRecord);
+        view.m_cells = cast_span<GridCell>(cursor, record_header.cell_count);
+        cursor += record_header.cell_count * sizeof(GridCell);
+        view.m_solution = cast_span<Placement>(cursor, record_header.solution_count);
+        archive.m_games.push_back(view);
+    }
+
+    const auto key = [](const GameView& view) { return std::pair(view.name(), view.difficulty()); };
+    if (!std::ranges::is_sorted(archive.m_games, {}, key))
+        return fail("index is not sorted");
+
+    return archive;
+}
+
+std::expected<void, std::string> PuzzleArchive::write(const std::filesystem::path& path, std::vector<Entry> entries)
+{
+    std::ranges::sort(entries, {}, [](const Entry& entry) { return std::tie(entry.name, entry.difficulty); });
+
+    const std::uint32_t    game_count = static_cast<std::uint32_t>(entries.size());
+    std::vector<std::byte> out;
+    append(out, Header{.magic = MAGIC, .version = VERSION, .game_count = game_count});
+
+    // The index is filled in once the record offsets are known
+    out.resize(sizeof(Header) + entries.size() * sizeof(IndexEntry));
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        const auto& [name, difficulty, game] = entries[i];
+        if (name.size() > MAX_NAME_LENGTH)
+            return std::unexpected("Puzzle name '" + name + "' is longer than " + std::to_string(MAX_NAME_LENGTH) +
+                                   " characters.");
+        if (i > 0 && entries[i - 1].name == name && entries[i - 1].difficulty == difficulty)
+            return std::unexpected("Puzzle '" + name + "' " + std::string(NytJsonProvider::to_string(difficulty)) +
+                                   " is listed twice.");
+
+        out.resize((out.size() + RECORD_ALIGNMENT - 1) / RECORD_ALIGNMENT * RECORD_ALIGNMENT);
+        const auto record = encode_record(*game);
+
+        IndexEntry entry{.name = {},
+                         .difficulty = static_cast<std::uint8_t>(difficulty),
+                         .reserved = {},
+                         .offset = static_cast<std::uint32_t>(out.size()),
+                         .size = static_cast<std::uint32_t>(record.size())};
+        std::ranges::copy(name, entry.name.begin());
+        std::memcpy(out.data() + sizeof(Header) + i * sizeof(IndexEntry), &entry, sizeof(entry));
+
+        out.insert(out.end(), record.begin(), record.end());
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+    if (!file)
+        return std::unexpected("Cannot write " + path.string());
+    return {};
+}
+
+PuzzleArchive::PuzzleArchive(PuzzleArchive&& other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr)),
+      m_size(std::exchange(other.m_size, 0)),
+      m_games(std::move(other.m_games))
+{
+}
+
+PuzzleArchive& PuzzleArchive::operator=(PuzzleArchive&& other) noexcept
+{
+    if (this != &other) {
+        unmap();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_games = std::move(other.m_games);
+    }
+    return *this;
+}
+
+PuzzleArchive::~PuzzleArchive()
+{
+    unmap();
+}
+
+void PuzzleArchive::unmap() noexcept
+{
+    if (m_data != nullptr) {
+        ::munmap(const_cast<std::byte*>(m_data), m_size);
+        m_data = nullptr;
+    }
+}
+
+const PuzzleArchive::GameView* PuzzleArchive::find(std::string_view name, Difficulty difficulty) const noexcept
+{
+    const auto key = [](const GameView& view) { return std::pair(view.name(), view.difficulty()); };
+    const auto it = std::ranges::lower_bound(m_games, std::pair(name, difficulty), {}, key);
+    return it != m_games.end() && it->name() == name && it->difficulty() == difficulty ? &*it : nullptr;
+}
+
+std::expected<std::size_t, std::string> pack_puzzle_files(const std::vector<std::filesystem::path>& files,
+                                                          const std::filesystem::path&              output)
+{
+    std::vector<NytJsonProvider>      providers;
+    std::deque<Game>                  unpacked;
+    std::vector<PuzzleArchive::Entry> entries;
+    providers.reserve(files.size());
+    for (const auto& file : files) {
+        // Games of an archive are unpacked, so the archive is unmapped again before `output`,
+        // which may be that same file, gets rewritten
+        if (file.extension() == PuzzleArchive::EXTENSION) {
+            auto archive = PuzzleArchive::open(file);
+            if (!archive)
+                return std::unexpected(archive.error());
+            for (std::size_t i = 0; i < archive->size(); ++i) {
+                const auto& view = (*archive)[i];
+                entries.push_back({.name = std::string(view.name()),
+                                   .difficulty = view.difficulty(),
+                                   .game = &unpacked.emplace_back(view.to_game())});
+            }
+            continue;
+        }
+        auto provider = NytJsonProvider::create(file);
+        if (!provider)
+            return std::unexpected(provider.error());
+        providers.push_back(std::move(*provider));
+        for (auto difficulty : {PuzzleArchive::Difficulty::EASY,
+                                PuzzleArchive::Difficulty::MEDIUM,
+                                PuzzleArchive::Difficulty::HARD}) {
+            entries.push_back({.name = file.stem().string(),
+                               .difficulty = difficulty,
+                               .game = &providers.back().get_game(difficulty)});
+        }
+    }
+
+    const auto game_count = entries.size();
+    if (auto written = PuzzleArchive::write(output, std::move(entries)); !written)
+        return std::unexpected(written.error());
+    return game_count;
+}
+
+}  // namespace pips
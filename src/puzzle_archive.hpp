@@ -0,0 +1,118 @@
+#pragma once
+
+#include "pips_data.hpp"
+#include "pips_game.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pips {
+
+// Packs games into one flat file and reads them back through a read-only memory mapping, so a
+// batch over years of puzzles opens a single file instead of parsing JSON per day.
+//
+// Layout, in the host byte order: a header, an index sorted by (name, difficulty), then one
+// record per game holding its dimensions, dominoes, zones, zone cells and official solution as
+// flat arrays. Records are validated when the archive is opened, views onto them are then
+// trusted and copy nothing. The engines do not read the views: solving a game still goes through
+// GameView::to_game(), which copies its arrays out and rebuilds its tables, so the archive saves the
+// JSON parsing but not the unpacking.
+class PuzzleArchive
+{
+public:
+    using Difficulty = NytJsonProvider::Difficulty;
+
+    // Names are the puzzle file stems, "2025-10-24" for a daily file, so the index sorts by date
+    static constexpr std::size_t      MAX_NAME_LENGTH = 15;
+    // Batch inputs with this extension are opened as archives
+    static constexpr std::string_view EXTENSION = ".pips";
+
+    // A game to pack, `game` must outlive the call to write()
+    struct Entry
+    {
+        std::string name;
+        Difficulty  difficulty;
+        const Game* game;
+    };
+
+    // Official solution placement as stored, two cells covered by one domino
+    struct Placement
+    {
+        GridCell first;
+        GridCell second;
+    };
+
+    struct ZoneView
+    {
+        RegionType                  type;
+        std::optional<std::uint8_t> target;
+        std::span<const GridCell>   indices;
+    };
+
+    // Zero-copy view of one packed game, valid while the archive is alive
+    class GameView
+    {
+    public:
+        [[nodiscard]] std::string_view           name() const noexcept { return m_name; }
+        [[nodiscard]] Difficulty                 difficulty() const noexcept { return m_difficulty; }
+        [[nodiscard]] BoardDimensions            dim() const noexcept { return m_dim; }
+        [[nodiscard]] std::span<const Domino>    dominoes() const noexcept { return m_dominoes; }
+        [[nodiscard]] std::size_t                zone_count() const noexcept { return m_zone_count; }
+        [[nodiscard]] ZoneView                   zone(std::size_t index) const noexcept;
+        [[nodiscard]] std::span<const Placement> official_solution() const noexcept { return m_solution; }
+
+        // The engines take a Game, this copies the arrays out of the mapping and builds its tables
+        [[nodiscard]] Game to_game() const;
+
+    private:
+        friend class PuzzleArchive;
+
+        std::string_view           m_name;
+        Difficulty                 m_difficulty{};
+        BoardDimensions            m_dim{};
+        std::span<const Domino>    m_dominoes;
+        const std::byte*           m_zones = nullptr;
+        std::size_t                m_zone_count = 0;
+        std::span<const GridCell>  m_cells;
+        std::span<const Placement> m_solution;
+    };
+
+    // Maps the archive at `path` and checks every record
+    static std::expected<PuzzleArchive, std::string> open(const std::filesystem::path& path);
+
+    // Writes `entries` to `path`, replacing it. Fails on a name longer than MAX_NAME_LENGTH or a
+    // duplicate (name, difficulty).
+    static std::expected<void, std::string> write(const std::filesystem::path& path, std::vector<Entry> entries);
+
+    PuzzleArchive(PuzzleArchive&& other) noexcept;
+    PuzzleArchive& operator=(PuzzleArchive&& other) noexcept;
+    ~PuzzleArchive();
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_games.size(); }
+    // Games in index order, by name then difficulty
+    [[nodiscard]] const GameView& operator[](std::size_t index) const noexcept { return m_games[index]; }
+    [[nodiscard]] const GameView* find(std::string_view name, Difficulty difficulty) const noexcept;
+
+private:
+    PuzzleArchive() noexcept = default;
+
+    void unmap() noexcept;
+
+    const std::byte*      m_data = nullptr;
+    std::size_t           m_size = 0;
+    std::vector<GameView> m_games;
+};
+
+// Reads every game of the puzzle files and archives and writes them to the archive at `output`.
+// Returns the number of games packed.
+std::expected<std::size_t, std::string> pack_puzzle_files(const std::vector<std::filesystem::path>& files,
+                                                          const std::filesystem::path&              output);
+
+}  // namespace pips
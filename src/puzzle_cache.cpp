@@ -0,0 +1,128 @@
+#include "puzzle_cache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <format>
+
+#include <spawn.h>
+#include <sys/wait.h>
+
+extern char** environ;
+
+namespace pips {
+
+namespace {
+
+// The date ends up in a file name and a URL, so only YYYY-MM-DD gets through
+bool is_date(std::string_view date)
+{
+    const auto digit = [](char c) { return c >= '0' && c <= '9'; };
+    return date.size() == 10 && date[4] == '-' && date[7] == '-' &&
+           std::ranges::all_of(date.substr(0, 4), digit) && std::ranges::all_of(date.substr(5, 2), digit) &&
+           std::ranges::all_of(date.substr(8, 2), digit);
+}
+
+// Copies or downloads the puzzle of `date` to `to`
+std::expected<void, std::string> fetch(std::string_view             date,
+                                       const PuzzleSource&          source,
+                                       const std::filesystem::path& to)
+{
+    const std::string file_name = std::string(date) + ".json";
+
+    std::error_code ec;
+    if (std::filesystem::is_directory(source.remote, ec)) {
+        const auto mirrored = std::filesystem::path(source.remote) / file_name;
+        std::filesystem::copy_file(mirrored, to, std::filesystem::copy_options::overwrite_existing, ec);
+        if (ec) {
+            return std::unexpected(std::format("Failed to copy {}: {}", mirrored.string(), ec.message()));
+        }
+        return {};
+    }
+
+    // curl gets its arguments as they are, no shell ever reads the URL or the path
+    std::string url = source.remote + "/" + file_name;
+    std::string output = to.string();
+    std::string curl = "curl", silent = "-s", fail = "-f", output_flag = "-o", url_flag = "--url";
+    std::array<char*, 8> argv = {curl.data(),
+                                 silent.data(),
+                                 fail.data(),
+                                 output_flag.data(),
+                                 output.data(),
+                                 url_flag.data(),
+                                 url.data(),
+                                 nullptr};
+
+    pid_t pid = 0;
+    if (const int error = posix_spawnp(&pid, "curl", nullptr, nullptr, argv.data(), environ); error != 0) {
+        return std::unexpected(
+            std::format("Failed to run curl for {}: {}. Check that curl is installed.", date, std::strerror(error)));
+    }
+    int status = 0;
+    while (waitpid(pid, &status, 0) == -1) {
+        if (errno != EINTR) {
+            return std::unexpected(std::format("Failed to wait for curl: {}", std::strerror(errno)));
+        }
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return std::unexpected(std::format("Failed to download puzzle for {} (curl exited with code {}).",
+                                           date,
+                                           WIFEXITED(status) ? WEXITSTATUS(status) : -1));
+    }
+    return {};
+}
+
+}  // namespace
+
+std::string today_date()
+{
+    const auto now = std::chrono::system_clock::now();
+    const auto tt = std::chrono::system_clock::to_time_t(now);
+    const auto tm = *std::localtime(&tt);
+    return std::format("{:04}-{:02}-{:02}", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+}
+
+std::expected<NytJsonProvider, std::string> load_daily_puzzle(std::string_view date, const PuzzleSource& source)
+{
+    if (!is_date(date)) {
+        return std::unexpected(std::format("Invalid date '{}', expected YYYY-MM-DD", date));
+    }
+
+    const auto cached_path = source.cache_dir / (std::string(date) + ".json");
+
+    std::error_code ec;
+    if (std::filesystem::exists(cached_path, ec)) {
+        auto cached = NytJsonProvider::create(cached_path);
+        if (cached || source.offline) {
+            return cached;
+        }
+    } else if (source.offline) {
+        return std::unexpected(
+            std::format("No cached puzzle for {} in {} and offline mode is on", date, source.cache_dir.string()));
+    }
+
+    std::filesystem::create_directories(source.cache_dir, ec);
+    auto partial_path = cached_path;
+    partial_path += ".part";
+
+    if (auto fetched = fetch(date, source, partial_path); !fetched) {
+        std::filesystem::remove(partial_path, ec);
+        return std::unexpected(fetched.error());
+    }
+    auto provider = NytJsonProvider::create(partial_path);
+    if (!provider) {
+        std::filesystem::remove(partial_path, ec);
+        return provider;
+    }
+    std::filesystem::rename(partial_path, cached_path, ec);
+    if (ec) {
+        return std::unexpected(
+            std::format("Failed to cache the puzzle as {}: {}", cached_path.string(), ec.message()));
+    }
+    return provider;
+}
+
+}  // namespace pips
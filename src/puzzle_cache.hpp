@@ -0,0 +1,34 @@
+#pragma once
+
+#include "pips_data.hpp"
+
+#include <expected>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace pips {
+
+// Where daily puzzles are looked up and fetched from
+struct PuzzleSource
+{
+    static constexpr std::string_view NYT_URL = "https://www.nytimes.com/svc/pips/v1";
+
+    // Puzzles are cached as <cache_dir>/<YYYY-MM-DD>.json
+    std::filesystem::path cache_dir = "data";
+    // A base URL curl fetches <remote>/<YYYY-MM-DD>.json from, or a local mirror directory
+    // holding files of that name, which are copied without spawning curl
+    std::string remote = std::string(NYT_URL);
+    // Only use the cache, fail when the puzzle is not in it
+    bool offline = false;
+};
+
+// Today's date in the local time zone, as YYYY-MM-DD
+[[nodiscard]] std::string today_date();
+
+// Loads the puzzle of `date` (YYYY-MM-DD). A cached file that parses is used as is; otherwise the
+// puzzle is fetched from the source, checked, and only then moved into the cache, so a failed or
+// truncated download never replaces a good file.
+std::expected<NytJsonProvider, std::string> load_daily_puzzle(std::string_view date, const PuzzleSource& source);
+
+}  // namespace pips
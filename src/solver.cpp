@@ -1,171 +1,1054 @@
 #include "solver.hpp"
 
 #include <algorithm>
+#include <bit>
 #include <numeric>
+#include <random>
+#include <ranges>
 
 namespace pips {
 
-Solver::Solver(const Game& game) : m_game(game), m_used_dominoes(game.dominoes.size(), false)
+template <std::size_t MaxCells>
+BasicSolver<MaxCells>::BasicSolver(const Game&                         game,
+                                   SolverOptions                       options,
+                                   std::shared_ptr<TranspositionTable> transpositions)
+    : m_game(game),
+      m_options(options),
+      m_cols(game.dim.cols),
+      m_kinds(game.tables.kinds),
+      m_transpositions(std::move(transpositions))
 {
+    // Every bit starts as a hole until a zone claims it, so padding past the board never looks free
+    m_holes = ~Board{};
+    for (const auto& [first, second] : game.tables.slots) {
+        m_neighbors[first].set(second);
+        m_neighbors[second].set(first);
+    }
+    const auto at = [&](int r, int c) {
+        return r < 0 || c < 0 || r >= game.dim.rows || c >= game.dim.cols ? OFF_BOARD
+                                                                           : static_cast<CellIndex>(r * m_cols + c);
+    };
+    for (std::uint8_t r = 0; r < game.dim.rows; ++r) {
+        for (std::uint8_t c = 0; c < game.dim.cols; ++c) {
+            const auto idx = to_index({r, c});
+            if ((r + c) % 2 == 0)
+                m_light.set(idx);
+            if (c > 0)
+                m_not_first_col.set(idx);
+            if (c + 1 < game.dim.cols)
+                m_not_last_col.set(idx);
+
+            m_rings[idx][0] = {at(r - 1, c - 1), at(r - 1, c),     at(r - 1, c + 1), at(r - 1, c + 2), at(r, c + 2),
+                               at(r + 1, c + 2), at(r + 1, c + 1), at(r + 1, c),     at(r + 1, c - 1), at(r, c - 1)};
+            m_rings[idx][1] = {at(r - 1, c - 1), at(r - 1, c),     at(r - 1, c + 1), at(r, c + 1),     at(r + 1, c + 1),
+                               at(r + 2, c + 1), at(r + 2, c),     at(r + 2, c - 1), at(r + 1, c - 1), at(r, c - 1)};
+        }
+    }
 
-    const auto& [rows, cols] = game.dim;
-    m_grid.assign(rows, std::vector<int8_t>(cols, HOLE));
-    m_zone_lookup.assign(rows, std::vector<const Zone*>(cols, nullptr));
+    for (const auto& kind : m_kinds) {
+        m_kind_remaining.push_back(kind.copies);
+    }
+    m_kind_order.resize(m_kinds.size());
+    reseed(m_options.seed);
+    for (const auto& domino : game.dominoes) {
+        m_pip_supply.halves[domino.p1]++;
+        m_pip_supply.halves[domino.p2]++;
+        m_supply_counts += GameTables::pip_count(domino.p1) + GameTables::pip_count(domino.p2);
+        m_pair_counts[domino.p1][domino.p2]++;
+        if (domino.p1 != domino.p2)
+            m_pair_counts[domino.p2][domino.p1]++;
+        m_pair_masks[domino.p1] |= static_cast<PipMask>(1u << domino.p2);
+        m_pair_masks[domino.p2] |= static_cast<PipMask>(1u << domino.p1);
+    }
 
-    for (const auto& zone : game.zones) {
+    m_kind_depths.resize(m_kinds.size());
+    m_zone_depths.resize(game.zones.size());
+    m_zone_masks.resize(game.zones.size());
+    m_zone_states.resize(game.zones.size());
+    m_zone_halos.resize(game.zones.size());
+    for (std::uint8_t zone_id = 0; const auto& zone : game.zones) {
+        m_zone_states[zone_id].size = static_cast<std::uint8_t>(zone.indices.size());
         for (const auto& cell : zone.indices) {
-            m_grid[cell.row][cell.col] = UNOCCUPIED;
-            m_zone_lookup[cell.row][cell.col] = &zone;
+            const auto idx = to_index(cell);
+            m_holes.reset(idx);
+            m_zone_masks[zone_id].set(idx);
+            m_zone_halos[zone_id] |= m_neighbors[idx];
+            m_zone_of[idx] = zone_id;
         }
+        m_zone_halos[zone_id] |= m_zone_masks[zone_id];
+        refresh_allowed_pips(zone_id);
+        zone_id++;
+    }
+
+    m_dirty_options = free_cells();
+
+    for (std::size_t kind = 0; kind < m_kinds.size(); ++kind) {
+        m_hash ^= kind_key(kind);
+    }
+    if (!m_transpositions && m_options.transposition_bytes > 0) {
+        m_transpositions = std::make_shared<TranspositionTable>(m_options.transposition_bytes);
+    }
+    if (m_options.backjumping) {
+        m_nogoods.resize(NOGOOD_SLOTS);
     }
 }
 
-std::optional<std::vector<DominoPlacement>> Solver::solve()
+template <std::size_t MaxCells>
+SolveResult BasicSolver<MaxCells>::solve(const SolveLimits& limits, std::stop_token stop)
 {
+    m_limiter.start(limits, std::move(stop), m_stats.nodes);
+    m_search_root = m_solution_placements.size();
+
+    if (!position_feasible()) {
+        return {.status = SolveStatus::UNSATISFIABLE};
+    }
+
     if (backtrack()) {
-        return m_solution_placements;
+        // Levels on the path to the solution that split never got back to their check
+        m_split_levels = 0;
+        return {.status = SolveStatus::SOLVED, .solution = m_solution_placements};
     }
 
-    return std::nullopt;
+    return {.status = m_limiter.status()};
 }
 
-std::optional<GridCell> Solver::find_unoccupied_cell() const
+template <std::size_t MaxCells>
+void BasicSolver<MaxCells>::reseed(std::uint64_t seed)
 {
-    for (std::uint8_t r = 0; r < m_game.dim.rows; ++r) {
-        for (std::uint8_t c = 0; c < m_game.dim.cols; ++c) {
-            if (m_grid[r][c] == UNOCCUPIED) {
-                return GridCell{r, c};
-            }
+    m_options.seed = seed;
+    std::iota(m_kind_order.begin(), m_kind_order.end(), std::uint8_t{0});
+    std::iota(m_tie_rank.begin(), m_tie_rank.end(), std::uint8_t{0});
+    if (seed != 0) {
+        std::mt19937_64 rng(seed);
+        std::ranges::shuffle(m_kind_order, rng);
+        std::ranges::shuffle(m_tie_rank, rng);
+    }
+}
+
+template <std::size_t MaxCells>
+auto BasicSolver<MaxCells>::to_index(const GridCell& cell) const noexcept -> CellIndex
+{
+    return static_cast<CellIndex>(cell.row * m_cols + cell.col);
+}
+
+template <std::size_t MaxCells>
+std::uint64_t BasicSolver<MaxCells>::cell_key(CellIndex cell, std::uint8_t pip) noexcept
+{
+    return zobrist_key(cell * (MAX_PIP + 1) + pip);
+}
+
+template <std::size_t MaxCells>
+std::uint64_t BasicSolver<MaxCells>::kind_key(std::size_t kind) const noexcept
+{
+    // Keyed by the pips rather than the kind's index, after every cell key
+    const auto [lo, hi] = std::minmax(m_kinds[kind].domino.p1, m_kinds[kind].domino.p2);
+    const auto pair = lo * (MAX_PIP + 1) + hi;
+    return zobrist_key(MAX_BOARD_CELLS * (MAX_PIP + 1) + pair * (MAX_BOARD_CELLS / 2 + 1) +
+                       m_kind_remaining[kind]);
+}
+
+template <std::size_t MaxCells>
+GridCell BasicSolver<MaxCells>::to_cell(CellIndex idx) const noexcept
+{
+    return {static_cast<std::uint8_t>(idx / m_cols), static_cast<std::uint8_t>(idx % m_cols)};
+}
+
+template <std::size_t MaxCells>
+auto BasicSolver<MaxCells>::find_unoccupied_cell() const -> std::optional<CellIndex>
+{
+    // Lowest free bit is the first free cell in row-major order
+    const auto free = free_cells();
+    if (free.none()) {
+        return std::nullopt;
+    }
+
+    return free.lowest();
+}
+
+template <std::size_t MaxCells>
+auto BasicSolver<MaxCells>::find_most_constrained_cell() -> std::optional<CellIndex>
+{
+    const auto free = free_cells();
+    if (free.none()) {
+        return std::nullopt;
+    }
+
+    for (auto dirty = m_dirty_options & free; dirty.any();) {
+        const auto cell = dirty.pop_lowest();
+        m_option_counts[cell] = count_options(cell, free);
+    }
+    m_dirty_options &= ~free;
+
+    // Ties go to the lowest rank, the earliest cell in reading order without a seed. A cell with
+    // at most one option cannot be beaten.
+    CellIndex best = free.lowest();
+    for (auto rest = free; rest.any();) {
+        const auto cell = rest.pop_lowest();
+        if (m_option_counts[cell] < m_option_counts[best] ||
+            (m_option_counts[cell] == m_option_counts[best] && m_tie_rank[cell] < m_tie_rank[best]))
+            best = cell;
+        if (m_option_counts[best] <= 1)
+            break;
+    }
+
+    return best;
+}
+
+template <std::size_t MaxCells>
+std::uint8_t BasicSolver<MaxCells>::count_options(CellIndex cell, const Board& free) const
+{
+    const PipMask allowed = m_zone_states[m_zone_of[cell]].allowed;
+
+    int count = 0;
+    for (auto partners = m_neighbors[cell] & free; partners.any();) {
+        const PipMask partner_allowed = m_zone_states[m_zone_of[partners.pop_lowest()]].allowed;
+        for (PipMask pips = allowed; pips != 0; pips &= pips - 1) {
+            count += std::popcount(static_cast<PipMask>(m_pair_masks[std::countr_zero(pips)] & partner_allowed));
         }
     }
 
-    return std::nullopt;
+    return static_cast<std::uint8_t>(count);
 }
 
-bool Solver::backtrack()
+template <std::size_t MaxCells>
+void BasicSolver<MaxCells>::refresh_allowed_pips(std::uint8_t zone_id)
 {
-    const auto next_cell_opt = find_unoccupied_cell();
-    if (!next_cell_opt) {
+    m_zone_states[zone_id].allowed = allowed_pips(zone_id);
+}
+
+template <std::size_t MaxCells>
+auto BasicSolver<MaxCells>::allowed_pips(std::uint8_t zone_id) const -> PipMask
+{
+    PipMask allowed = 0;
+    for (std::uint8_t pip = 0; pip <= MAX_PIP; ++pip) {
+        if (check_zone_constraints(zone_id, pip))
+            allowed |= static_cast<PipMask>(1u << pip);
+    }
+
+    const auto& state = m_zone_states[zone_id];
+    if (!m_options.forward_checking || state.filled == state.size) {
+        return allowed;
+    }
+
+    // Pip v can only go in if the unused dominoes can still complete the zone around it
+    return m_pip_supply.completable_pips(m_game.zones[zone_id], state, allowed) & assignable_pips(zone_id);
+}
+
+template <std::size_t MaxCells>
+bool BasicSolver<MaxCells>::fits_assignment(std::uint8_t zone_id, std::uint8_t pip) const
+{
+    const auto& table = m_game.tables.zone_assignments[zone_id];
+    if (!m_options.zone_assignments || !table.restricts())
         return true;
+    return table.next_pips[m_zone_states[zone_id].assignment] & (1u << pip);
+}
+
+template <std::size_t MaxCells>
+auto BasicSolver<MaxCells>::assignable_pips(std::uint8_t zone_id) const -> PipMask
+{
+    const auto& table = m_game.tables.zone_assignments[zone_id];
+    if (!m_options.zone_assignments || !table.restricts())
+        return ALL_PIPS;
+
+    // What the assignments within reach still lack, of those the unused dominoes can supply
+    const auto index = m_zone_states[zone_id].assignment;
+    if (GameTables::counts_within(table.most_missing[index], m_supply_counts))
+        return table.next_pips[index];
+
+    GameTables::PipCounts missing = 0;
+    for (auto i = table.begin[index]; i < table.begin[index + 1]; ++i) {
+        if (GameTables::counts_within(table.missing[i], m_supply_counts))
+            missing |= table.missing[i];
     }
+    return GameTables::values_in(missing);
+}
 
-    const auto& cell = *next_cell_opt;
+template <std::size_t MaxCells>
+bool BasicSolver<MaxCells>::propagate()
+{
+    // Using a domino shrinks the supply for every zone, not just the two it landed in
+    for (std::uint8_t zone_id = 0; zone_id < m_zone_states.size(); ++zone_id) {
+        auto& state = m_zone_states[zone_id];
+        if (state.filled == state.size)
+            continue;
 
-    // generate all valid placements for a domino at the current cell
-    const auto enumerate_placements = [&](const Domino& domino) {
-        std::vector<std::tuple<GridCell, GridCell, uint8_t, uint8_t>> placements;
+        if (!m_pip_supply.can_complete(m_game.zones[zone_id], state)) {
+            record_prune(zone_id);
+            return false;
+        }
 
-        const auto try_add = [&](GridCell c2, uint8_t p1, uint8_t p2) {
-            if (c2.row < m_game.dim.rows && c2.col < m_game.dim.cols && m_grid[c2.row][c2.col] == UNOCCUPIED) {
-                placements.emplace_back(cell, c2, p1, p2);
+        const PipMask allowed = allowed_pips(zone_id);
+        if (allowed == 0) {
+            record_prune(zone_id);
+            return false;
+        }
+
+        if (allowed != state.allowed) {
+            state.allowed = allowed;
+            m_dirty_options |= m_zone_halos[zone_id];
+        }
+    }
+
+    return true;
+}
+
+template <std::size_t MaxCells>
+bool BasicSolver<MaxCells>::position_feasible()
+{
+    if (m_options.zone_assignments && !m_game.tables.assignable) {
+        return false;
+    }
+    if (m_options.forward_checking && !propagate()) {
+        return false;
+    }
+    // The search only checks the regions next to each placement, the starting position needs all of them
+    DepthMask conflict = 0;
+    return !m_options.region_pruning || regions_tileable({}, free_cells(), conflict);
+}
+
+template <std::size_t MaxCells>
+auto BasicSolver<MaxCells>::expand(const Board& cells) const noexcept -> Board
+{
+    // Shifting by one wraps between rows, the column masks drop the cells that crossed over
+    return cells | ((cells << 1) & m_not_first_col) | ((cells >> 1) & m_not_last_col) | (cells << m_cols) |
+           (cells >> m_cols);
+}
+
+template <std::size_t MaxCells>
+bool BasicSolver<MaxCells>::may_split(CellIndex cell, CellIndex other, const Board& free) const
+{
+    // Positions along the ring that touch the slot rather than just one of its corners
+    static constexpr std::array<std::uint16_t, 2> SIDES = {0b1011010110, 0b1101011010};
+
+    const bool  vertical = std::max(cell, other) - std::min(cell, other) == m_cols;
+    const auto& ring = m_rings[std::min(cell, other)][vertical];
+    const auto  is_free = [&](std::size_t i) { return ring[i] != OFF_BOARD && free.test(ring[i]); };
+
+    // Walk once around from a blocked position, counting the runs of free cells that reach a side
+    std::size_t start = 0;
+    while (start < ring.size() && is_free(start)) {
+        start++;
+    }
+    if (start == ring.size()) {
+        return false;
+    }
+
+    std::size_t runs = 0;
+    bool        reaches_side = false;
+    for (std::size_t k = 1; k <= ring.size(); ++k) {
+        const auto i = (start + k) % ring.size();
+        if (is_free(i)) {
+            reaches_side |= (SIDES[vertical] >> i) & 1;
+        } else if (reaches_side) {
+            runs++;
+            reaches_side = false;
+        }
+    }
+    return runs > 1;
+}
+
+template <std::size_t MaxCells>
+bool BasicSolver<MaxCells>::regions_tileable(const Board& taken, Board seeds, DepthMask& conflict) const
+{
+    const Board free = free_cells() & ~taken;
+    for (seeds &= free; seeds.any();) {
+        Board region;
+        region.set(seeds.lowest());
+        for (Board previous; previous != region;) {
+            previous = region;
+            region = expand(region) & free;
+        }
+        seeds &= ~region;
+
+        if ((region & m_light).count() * 2 != region.count()) {
+            // Holes never move, the region is fixed by the placements around it
+            for (auto walls = expand(region) & m_occupied; walls.any();) {
+                conflict |= DepthMask{1} << m_cover_depth[walls.pop_lowest()];
             }
-        };
+            return false;
+        }
+    }
+    return true;
+}
+
+template <std::size_t MaxCells>
+void BasicSolver<MaxCells>::record_prune(std::uint8_t zone_id) noexcept
+{
+    if constexpr (SolverStats::ENABLED)
+        m_stats.record_prune(m_game.zones[zone_id].type);
+}
+
+template <std::size_t MaxCells>
+void BasicSolver<MaxCells>::record_branching(std::size_t depth, std::size_t children)
+{
+    if constexpr (SolverStats::ENABLED)
+        m_stats.record_branching(depth, children);
+}
+
+template <std::size_t MaxCells>
+void BasicSolver<MaxCells>::place(CellIndex cell, std::uint8_t pip)
+{
+    m_occupied.set(cell);
+    m_pip_planes[pip].set(cell);
+    m_hash ^= cell_key(cell, pip);
 
-        // Horizontal
-        try_add({cell.row, static_cast<std::uint8_t>(cell.col + 1)}, domino.p1, domino.p2);
-        if (domino.p1 != domino.p2) {
-            try_add({cell.row, static_cast<std::uint8_t>(cell.col + 1)}, domino.p2, domino.p1);
+    const auto zone_id = m_zone_of[cell];
+    m_cover_depth[cell] = static_cast<std::uint8_t>(m_solution_placements.size());
+    m_zone_depths[zone_id] |= DepthMask{1} << m_cover_depth[cell];
+
+    auto& state = m_zone_states[zone_id];
+    if (state.filled++ == 0) {
+        state.first = pip;
+    }
+    state.sum += pip;
+    state.seen |= static_cast<PipMask>(1u << pip);
+    state.assignment += m_game.tables.zone_assignments[zone_id].stride[pip];
+
+    // Covering or freeing a cell changes the options of its neighbours whether or not any zone's
+    // candidate pips change, and a cell freed again recounts its own
+    if (m_options.branching == BranchingHeuristic::MOST_CONSTRAINED) {
+        m_dirty_options |= m_neighbors[cell];
+        m_dirty_options.set(cell);
+    }
+    // With forward checking propagate() refreshes every zone after the whole domino is down
+    if (m_options.branching == BranchingHeuristic::MOST_CONSTRAINED && !m_options.forward_checking) {
+        refresh_allowed_pips(zone_id);
+        m_dirty_options |= m_zone_halos[zone_id];
+    }
+}
+
+template <std::size_t MaxCells>
+void BasicSolver<MaxCells>::remove(CellIndex cell, std::uint8_t pip)
+{
+    m_occupied.reset(cell);
+    m_pip_planes[pip].reset(cell);
+    m_hash ^= cell_key(cell, pip);
+
+    // Both halves of a placement are always taken back together
+    const auto zone_id = m_zone_of[cell];
+    m_zone_depths[zone_id] &= ~(DepthMask{1} << m_cover_depth[cell]);
+
+    auto& state = m_zone_states[zone_id];
+    state.filled--;
+    state.sum -= pip;
+    state.assignment -= m_game.tables.zone_assignments[zone_id].stride[pip];
+    // Only forget the value once no other cell of the zone still holds it
+    if ((m_pip_planes[pip] & m_zone_masks[zone_id]).none()) {
+        state.seen &= static_cast<PipMask>(~(1u << pip));
+    }
+
+    // Covering or freeing a cell changes the options of its neighbours whether or not any zone's
+    // candidate pips change, and a cell freed again recounts its own
+    if (m_options.branching == BranchingHeuristic::MOST_CONSTRAINED) {
+        m_dirty_options |= m_neighbors[cell];
+        m_dirty_options.set(cell);
+    }
+    // With forward checking propagate() refreshes every zone after the whole domino is down
+    if (m_options.branching == BranchingHeuristic::MOST_CONSTRAINED && !m_options.forward_checking) {
+        refresh_allowed_pips(zone_id);
+        m_dirty_options |= m_zone_halos[zone_id];
+    }
+}
+
+template <std::size_t MaxCells>
+void BasicSolver<MaxCells>::use_domino(std::size_t kind)
+{
+    m_hash ^= kind_key(kind);
+    m_kind_remaining[kind]--;
+    m_hash ^= kind_key(kind);
+    m_kind_depths[kind] |= DepthMask{1} << m_solution_placements.size();
+
+    const auto& [p1, p2] = m_kinds[kind].domino;
+    m_pip_supply.halves[p1]--;
+    m_pip_supply.halves[p2]--;
+    m_supply_counts -= GameTables::pip_count(p1) + GameTables::pip_count(p2);
+    const bool exhausted = --m_pair_counts[p1][p2] == 0;
+    if (p1 != p2)
+        --m_pair_counts[p2][p1];
+
+    if (exhausted) {
+        m_pair_masks[p1] &= static_cast<PipMask>(~(1u << p2));
+        m_pair_masks[p2] &= static_cast<PipMask>(~(1u << p1));
+        // Every cell may have relied on that pair
+        m_dirty_options = ~Board{};
+    }
+}
+
+template <std::size_t MaxCells>
+void BasicSolver<MaxCells>::release_domino(std::size_t kind)
+{
+    m_hash ^= kind_key(kind);
+    m_kind_remaining[kind]++;
+    m_hash ^= kind_key(kind);
+    m_kind_depths[kind] &= ~(DepthMask{1} << m_solution_placements.size());
+
+    const auto& [p1, p2] = m_kinds[kind].domino;
+    m_pip_supply.halves[p1]++;
+    m_pip_supply.halves[p2]++;
+    m_supply_counts += GameTables::pip_count(p1) + GameTables::pip_count(p2);
+    const bool restored = m_pair_counts[p1][p2]++ == 0;
+    if (p1 != p2)
+        ++m_pair_counts[p2][p1];
+
+    if (restored) {
+        m_pair_masks[p1] |= static_cast<PipMask>(1u << p2);
+        m_pair_masks[p2] |= static_cast<PipMask>(1u << p1);
+        m_dirty_options = ~Board{};
+    }
+}
+
+template <std::size_t MaxCells>
+template <typename Visit>
+bool BasicSolver<MaxCells>::for_each_branch(Visit&& visit, std::optional<CellIndex> at)
+{
+    const auto next_cell_opt = at ? at
+                               : m_options.branching == BranchingHeuristic::MOST_CONSTRAINED ? find_most_constrained_cell()
+                                                                                              : find_unoccupied_cell();
+    if (!next_cell_opt) {
+        return true;
+    }
+
+    const CellIndex cell = *next_cell_opt;
+    const auto      depth = m_solution_placements.size();
+    const DepthMask own = DepthMask{1} << depth;
+
+    // Fail first: a cell nothing can cover dooms the whole subtree. Backjumping still walks the
+    // options below, to learn which placements doomed it. A cell picked by the caller may have a
+    // stale count.
+    if (!at && m_options.branching == BranchingHeuristic::MOST_CONSTRAINED && m_option_counts[cell] == 0) {
+        if constexpr (SolverStats::ENABLED)
+            m_stats.dead_cells++;
+        if (!m_options.backjumping) {
+            return false;
         }
+    }
 
-        // Vertical
-        try_add({static_cast<std::uint8_t>(cell.row + 1), cell.col}, domino.p1, domino.p2);
-        if (domino.p1 != domino.p2) {
-            try_add({static_cast<std::uint8_t>(cell.row + 1), cell.col}, domino.p2, domino.p1);
+    // Placements the failures so far depend on, starting with those that took a neighbour
+    DepthMask conflict = 0;
+    if (m_options.backjumping) {
+        for (auto taken = m_neighbors[cell] & m_occupied; taken.any();) {
+            conflict |= DepthMask{1} << m_cover_depth[taken.pop_lowest()];
         }
+    }
 
-        return placements;
-    };
+    // Partners and candidate pips are captured up front, deeper propagations overwrite the zone masks
+    std::array<CellIndex, 4> partners{};
+    std::array<PipMask, 4>   partner_allowed{};
+    std::size_t              partner_count = 0;
+    for (auto free_neighbors = m_neighbors[cell] & free_cells(); free_neighbors.any(); ++partner_count) {
+        partners[partner_count] = free_neighbors.pop_lowest();
+        partner_allowed[partner_count] = m_zone_states[m_zone_of[partners[partner_count]]].allowed;
+    }
+    // A slot that cuts off an untileable region fails whatever domino goes on it
+    if (m_options.region_pruning) {
+        std::size_t kept = 0;
+        for (std::size_t s = 0; s < partner_count; ++s) {
+            Board slot;
+            slot.set(cell);
+            slot.set(partners[s]);
+            if (!may_split(cell, partners[s], free_cells()) || regions_tileable(slot, expand(slot), conflict)) {
+                partners[kept] = partners[s];
+                partner_allowed[kept++] = partner_allowed[s];
+            } else if constexpr (SolverStats::ENABLED) {
+                m_stats.region_prunes++;
+            }
+        }
+        partner_count = kept;
+    }
+    if (partner_count == 0 && !m_options.backjumping) {
+        return false;
+    }
+    const PipMask cell_allowed = m_zone_states[m_zone_of[cell]].allowed;
+    std::size_t   children = 0;
 
-    for (std::size_t i = 0; i < m_game.dominoes.size(); ++i) {
-        if (m_used_dominoes[i])
+    for (std::size_t k = 0; k < m_kinds.size() && partner_count != 0; ++k) {
+        const std::size_t kind = m_kind_order[k];
+        if (m_kind_remaining[kind] == 0) {
+            conflict |= m_kind_depths[kind];
             continue;
+        }
 
-        const auto& domino = m_game.dominoes[i];
-        for (const auto& [c1, c2, p1, p2] : enumerate_placements(domino)) {
-            // Apply placement
-            m_grid[c1.row][c1.col] = p1;
-            m_grid[c2.row][c2.col] = p2;
-            m_used_dominoes[i] = true;
+        const auto& domino = m_kinds[kind].domino;
+        for (std::size_t s = 0; s < partner_count; ++s) {
+            const CellIndex other = partners[s];
 
-            auto* zone1 = m_zone_lookup[c1.row][c1.col];
-            auto* zone2 = m_zone_lookup[c2.row][c2.col];
+            for (std::size_t o = 0; o < m_kinds[kind].orientation_count; ++o) {
+                const auto [p1, p2] = m_kinds[kind].orientations[o];
 
-            // Validate zones
-            bool valid = check_zone_constraints(*zone1);
-            if (valid && zone1 != zone2) {
-                valid = check_zone_constraints(*zone2);
-            }
+                // Candidate pips from the last propagation still bound both halves
+                if (m_options.forward_checking && !(cell_allowed & (1u << p1) && partner_allowed[s] & (1u << p2))) {
+                    if (m_options.backjumping) {
+                        conflict |= !(cell_allowed & (1u << p1)) ? explain_pip(cell, p1) : explain_pip(other, p2);
+                    }
+                    continue;
+                }
 
-            if (valid) {
-                m_solution_placements.emplace_back(domino, PlacedPip{c1, p1}, PlacedPip{c2, p2});
-                if (backtrack())
-                    return true;
-                // undo path
-                m_solution_placements.pop_back();
+                // Validate each half against its zone before applying it, so both halves
+                // are checked in turn when they share a zone
+                if (!check_zone_constraints(m_zone_of[cell], p1) || !fits_assignment(m_zone_of[cell], p1)) {
+                    record_prune(m_zone_of[cell]);
+                    conflict |= m_zone_depths[m_zone_of[cell]];
+                    continue;
+                }
+                place(cell, p1);
+
+                if (!check_zone_constraints(m_zone_of[other], p2) || !fits_assignment(m_zone_of[other], p2)) {
+                    record_prune(m_zone_of[other]);
+                    conflict |= m_zone_depths[m_zone_of[other]];
+                    remove(cell, p1);
+                    continue;
+                }
+                place(other, p2);
+                use_domino(kind);
+
+                bool viable = true;
+                if (m_options.backjumping) {
+                    if (const auto nogood = violated_nogood(to_literal(cell, p1, other, p2))) {
+                        if constexpr (SolverStats::ENABLED)
+                            m_stats.nogood_prunes++;
+                        conflict |= *nogood;
+                        viable = false;
+                    }
+                }
+                if (viable && m_options.forward_checking && !propagate()) {
+                    // The supply bounds hold every domino used so far responsible
+                    conflict |= placed_depths();
+                    viable = false;
+                }
+
+                if (viable) {
+                    m_solution_placements.emplace_back(
+                        domino, PlacedPip{to_cell(cell), p1}, PlacedPip{to_cell(other), p2});
+                    children++;
+                    if (visit()) {
+                        record_branching(depth, children);
+                        return true;
+                    }
+                    // undo path
+                    m_solution_placements.pop_back();
+                    if constexpr (SolverStats::ENABLED)
+                        m_stats.backtracks++;
+
+                    // A search cut short unwinds to the root without trying the siblings, and a
+                    // level that split leaves them to whoever took them
+                    if (m_limiter.interrupted() || (m_split_levels & own) != 0) {
+                        m_split_levels &= ~own;
+                        remove(cell, p1);
+                        remove(other, p2);
+                        release_domino(kind);
+                        record_branching(depth, children);
+                        m_conflict = NOT_A_FAILURE;
+                        return false;
+                    }
+
+                    if (m_options.backjumping) {
+                        // A failure this placement played no part in is the same for every sibling,
+                        // skip them and hand it straight up to the culprit
+                        if (m_conflict != NOT_A_FAILURE && !(m_conflict & own)) {
+                            remove(cell, p1);
+                            remove(other, p2);
+                            release_domino(kind);
+                            if constexpr (SolverStats::ENABLED)
+                                m_stats.backjumped_levels++;
+                            record_branching(depth, children);
+                            return false;
+                        }
+                        conflict |= m_conflict;
+                    }
+                }
+
+                // Undo
+                remove(cell, p1);
+                remove(other, p2);
+                release_domino(kind);
             }
+        }
+    }
 
-            // Undo
-            m_grid[c1.row][c1.col] = UNOCCUPIED;
-            m_grid[c2.row][c2.col] = UNOCCUPIED;
-            m_used_dominoes[i] = false;
+    record_branching(depth, children);
+    if (m_options.backjumping) {
+        m_conflict = conflict == NOT_A_FAILURE ? NOT_A_FAILURE : conflict & ~own;
+        if (m_conflict != NOT_A_FAILURE) {
+            learn_nogood(m_conflict);
         }
     }
+    return false;
+}
+
+template <std::size_t MaxCells>
+auto BasicSolver<MaxCells>::placed_depths() const noexcept -> DepthMask
+{
+    return (DepthMask{1} << m_solution_placements.size()) - 1;
+}
+
+template <std::size_t MaxCells>
+auto BasicSolver<MaxCells>::explain_pip(CellIndex cell, std::uint8_t pip) const -> DepthMask
+{
+    // Only the zone's own placements can break its constraint or assignments, anything else came
+    // from the supply
+    const auto zone_id = m_zone_of[cell];
+    return check_zone_constraints(zone_id, pip) && fits_assignment(zone_id, pip) ? placed_depths()
+                                                                                : m_zone_depths[zone_id];
+}
+
+template <std::size_t MaxCells>
+auto BasicSolver<MaxCells>::to_literal(CellIndex a, std::uint8_t pa, CellIndex b, std::uint8_t pb) noexcept -> Literal
+{
+    if (b < a) {
+        std::swap(a, b);
+        std::swap(pa, pb);
+    }
+    return ((static_cast<Literal>(a) << 3 | pa) << 10 | static_cast<Literal>(b) << 3 | pb) + 1;
+}
+
+template <std::size_t MaxCells>
+auto BasicSolver<MaxCells>::to_literal(const DominoPlacement& placement) const noexcept -> Literal
+{
+    const auto& [domino, half1, half2] = placement;
+    return to_literal(to_index(half1.cell), half1.pip, to_index(half2.cell), half2.pip);
+}
+
+template <std::size_t MaxCells>
+bool BasicSolver<MaxCells>::holds(Literal literal) const noexcept
+{
+    const auto a = static_cast<CellIndex>((literal - 1) >> 13);
+    const auto pa = static_cast<std::uint8_t>((literal - 1) >> 10 & 7);
+    const auto b = static_cast<CellIndex>((literal - 1) >> 3 & 127);
+    const auto pb = static_cast<std::uint8_t>((literal - 1) & 7);
+
+    // Same depth on both cells means the same domino covers them
+    return m_pip_planes[pa].test(a) && m_pip_planes[pb].test(b) && m_cover_depth[a] == m_cover_depth[b];
+}
+
+template <std::size_t MaxCells>
+auto BasicSolver<MaxCells>::violated_nogood(Literal placed) const -> std::optional<DepthMask>
+{
+    const auto& nogood = m_nogoods[zobrist_key(placed) & (NOGOOD_SLOTS - 1)];
+    if (nogood.literals[0] != placed) {
+        return std::nullopt;
+    }
+
+    DepthMask depths = 0;
+    for (const auto literal : nogood.literals | std::views::drop(1)) {
+        if (literal == 0)
+            break;
+        if (!holds(literal))
+            return std::nullopt;
+        depths |= DepthMask{1} << m_cover_depth[(literal - 1) >> 13];
+    }
+    return depths;
+}
+
+template <std::size_t MaxCells>
+void BasicSolver<MaxCells>::learn_nogood(DepthMask conflict)
+{
+    const auto size = static_cast<std::size_t>(std::popcount(conflict));
+    if (size == 0 || size > MAX_NOGOOD_SIZE) {
+        return;
+    }
+
+    std::array<Literal, MAX_NOGOOD_SIZE> literals{};
+    for (std::size_t i = 0; conflict != 0; conflict &= conflict - 1) {
+        literals[i++] = to_literal(m_solution_placements[std::countr_zero(conflict)]);
+    }
+
+    // Stored once per literal, so placing any of them last finds it. Newest nogood wins a slot.
+    for (std::size_t trigger = 0; trigger < size; ++trigger) {
+        auto& nogood = m_nogoods[zobrist_key(literals[trigger]) & (NOGOOD_SLOTS - 1)];
+        nogood.literals = literals;
+        std::swap(nogood.literals[0], nogood.literals[trigger]);
+    }
+}
 
+template <std::size_t MaxCells>
+bool BasicSolver<MaxCells>::enter_node()
+{
+    m_stats.nodes++;
+    if constexpr (SolverStats::ENABLED)
+        m_stats.max_depth = std::max(m_stats.max_depth, static_cast<std::uint32_t>(m_solution_placements.size()));
+    return m_limiter.admit(m_stats.nodes, m_solution_placements.size());
+}
+
+template <std::size_t MaxCells>
+bool BasicSolver<MaxCells>::known_dead()
+{
+    if (!m_transpositions) {
+        return false;
+    }
+
+    const bool hit = m_transpositions->contains(m_hash);
+    if constexpr (SolverStats::ENABLED) {
+        if (hit)
+            m_stats.transposition_hits++;
+        else
+            m_stats.transposition_misses++;
+    }
+    return hit;
+}
+
+template <std::size_t MaxCells>
+void BasicSolver<MaxCells>::record_dead()
+{
+    if (m_transpositions && !m_limiter.interrupted()) {
+        m_transpositions->insert(m_hash);
+    }
+}
+
+template <std::size_t MaxCells>
+bool BasicSolver<MaxCells>::backtrack()
+{
+    if (!enter_node()) {
+        m_conflict = NOT_A_FAILURE;
+        return false;
+    }
+    if (known_dead()) {
+        m_conflict = placed_depths();
+        return false;
+    }
+
+    const auto splits = m_split_count;
+    if (for_each_branch([this] { return backtrack(); })) {
+        return true;
+    }
+    if (m_split_count == splits) {
+        record_dead();
+    }
     return false;
 }
 
-bool Solver::check_zone_constraints(const Zone& zone) const
+template <std::size_t MaxCells>
+bool BasicSolver<MaxCells>::count_backtrack(std::size_t limit, SolutionCount& result)
 {
-    std::vector<std::uint8_t> pips_in_zone;
-    bool                      is_zone_full = true;
+    if (!enter_node()) {
+        return true;
+    }
+
+    if (free_cells().none()) {
+        result.count++;
+        if (!result.official_found && matches_official_solution(m_game, m_solution_placements))
+            result.official_found = true;
+        m_conflict = NOT_A_FAILURE;
+        return result.count >= limit;
+    }
+
+    if (known_dead()) {
+        m_conflict = placed_depths();
+        return false;
+    }
+
+    // A subtree holding a solution reports NOT_A_FAILURE, only empty ones may be jumped over
+    const auto counted = result.count;
+    const bool cut = for_each_branch([&] { return count_backtrack(limit, result); });
+    if (!cut && result.count == counted) {
+        record_dead();
+    }
+    return cut;
+}
+
+template <std::size_t MaxCells>
+SolutionCount BasicSolver<MaxCells>::count_solutions(std::size_t limit, std::stop_token stop)
+{
+    m_limiter.start({}, std::move(stop), m_stats.nodes);
+
+    SolutionCount result;
+    if (limit == 0) {
+        return result;
+    }
+    if (!position_feasible()) {
+        result.complete = true;
+        return result;
+    }
+
+    // Stopping early leaves the path to the last solution applied, unwind it back to the caller's position
+    const auto base = m_solution_placements.size();
+    const bool cut_off = count_backtrack(limit, result);
+    pop_to(base);
+
+    result.complete = !cut_off;
+    return result;
+}
 
-    for (const auto& [row, col] : zone.indices) {
-        const auto pip_val = m_grid[row][col];
-        if (pip_val != UNOCCUPIED) {
-            pips_in_zone.push_back(pip_val);
-        } else {
-            is_zone_full = false;
+template <std::size_t MaxCells>
+std::vector<DominoPlacement> BasicSolver<MaxCells>::candidate_placements()
+{
+    std::vector<DominoPlacement> candidates;
+    if (!position_feasible()) {
+        return candidates;
+    }
+
+    for_each_branch([&] {
+        candidates.push_back(m_solution_placements.back());
+        // Not a failure, every sibling is still wanted
+        m_conflict = NOT_A_FAILURE;
+        return false;
+    });
+    return candidates;
+}
+
+template <std::size_t MaxCells>
+void BasicSolver<MaxCells>::count_expansion(std::size_t children)
+{
+    m_stats.nodes++;
+    if constexpr (SolverStats::ENABLED)
+        m_stats.max_depth = std::max(m_stats.max_depth, static_cast<std::uint32_t>(m_solution_placements.size()));
+    record_branching(m_solution_placements.size(), children);
+}
+
+template <std::size_t MaxCells>
+std::vector<DominoPlacement> BasicSolver<MaxCells>::split_search()
+{
+    for (auto level = m_search_root; level < m_solution_placements.size(); ++level) {
+        const DepthMask bit = DepthMask{1} << level;
+        if ((m_split_levels & bit) == 0) {
+            m_split_levels |= bit;
+            m_split_count++;
+            return {m_solution_placements.begin(), m_solution_placements.begin() + level + 1};
         }
     }
+    return {};
+}
 
-    if (pips_in_zone.empty()) {
-        return true;
+template <std::size_t MaxCells>
+std::vector<DominoPlacement> BasicSolver<MaxCells>::branches_after(const DominoPlacement& taken)
+{
+    std::vector<DominoPlacement> branches;
+    if (!position_feasible()) {
+        return branches;
     }
 
+    const auto cell = to_index(taken.placement1.cell);
+    const auto after = branch_rank(taken);
+    for_each_branch(
+        [&] {
+            if (branch_rank(m_solution_placements.back()) > after)
+                branches.push_back(m_solution_placements.back());
+            m_conflict = NOT_A_FAILURE;
+            return false;
+        },
+        cell);
+    return branches;
+}
+
+template <std::size_t MaxCells>
+auto BasicSolver<MaxCells>::branch_rank(const DominoPlacement& placement) const
+    -> std::tuple<std::size_t, CellIndex, std::size_t>
+{
+    const auto  p1 = placement.placement1.pip;
+    const auto  p2 = placement.placement2.pip;
+    const auto  kind = *find_kind(p1, p2);
+    const auto  rank = std::ranges::find(m_kind_order, kind) - m_kind_order.begin();
+    const auto& orientations = m_kinds[kind].orientations;
+    const auto  orientation = std::ranges::find(orientations, std::array{p1, p2}) - orientations.begin();
+    return {static_cast<std::size_t>(rank),
+            to_index(placement.placement2.cell),
+            static_cast<std::size_t>(orientation)};
+}
+
+template <std::size_t MaxCells>
+std::optional<std::size_t> BasicSolver<MaxCells>::find_kind(std::uint8_t p1, std::uint8_t p2) const
+{
+    for (std::size_t kind = 0; kind < m_kinds.size(); ++kind) {
+        const auto& domino = m_kinds[kind].domino;
+        if ((domino.p1 == p1 && domino.p2 == p2) || (domino.p1 == p2 && domino.p2 == p1)) {
+            return kind;
+        }
+    }
+    return std::nullopt;
+}
+
+template <std::size_t MaxCells>
+bool BasicSolver<MaxCells>::push(const DominoPlacement& placement)
+{
+    const auto& [domino, half1, half2] = placement;
+
+    const auto on_board = [&](const GridCell& c) { return c.row < m_game.dim.rows && c.col < m_game.dim.cols; };
+    if (!on_board(half1.cell) || !on_board(half2.cell) || !half1.cell.is_adjacent(half2.cell)) {
+        return false;
+    }
+
+    const auto cell = to_index(half1.cell);
+    const auto other = to_index(half2.cell);
+    const auto free = free_cells();
+    if (!free.test(cell) || !free.test(other)) {
+        return false;
+    }
+
+    const auto kind = find_kind(half1.pip, half2.pip);
+    if (!kind || m_kind_remaining[*kind] == 0 || find_kind(domino.p1, domino.p2) != kind) {
+        return false;
+    }
+
+    if (!check_zone_constraints(m_zone_of[cell], half1.pip) || !fits_assignment(m_zone_of[cell], half1.pip)) {
+        return false;
+    }
+    place(cell, half1.pip);
+
+    if (!check_zone_constraints(m_zone_of[other], half2.pip) || !fits_assignment(m_zone_of[other], half2.pip)) {
+        remove(cell, half1.pip);
+        return false;
+    }
+    place(other, half2.pip);
+    use_domino(*kind);
+
+    m_solution_placements.push_back(placement);
+    return true;
+}
+
+template <std::size_t MaxCells>
+void BasicSolver<MaxCells>::pop()
+{
+    const auto [domino, half1, half2] = m_solution_placements.back();
+    m_solution_placements.pop_back();
+
+    remove(to_index(half1.cell), half1.pip);
+    remove(to_index(half2.cell), half2.pip);
+    release_domino(*find_kind(half1.pip, half2.pip));
+}
+
+template <std::size_t MaxCells>
+void BasicSolver<MaxCells>::pop_to(std::size_t depth)
+{
+    while (m_solution_placements.size() > depth) {
+        pop();
+    }
+}
+
+template <std::size_t MaxCells>
+bool BasicSolver<MaxCells>::check_zone_constraints(std::uint8_t zone_id, std::uint8_t pip) const
+{
+    const auto& zone = m_game.zones[zone_id];
+    const auto& state = m_zone_states[zone_id];
+
+    const bool is_zone_full = state.filled + 1 == state.size;
+    const int  new_sum = state.sum + pip;
+
     switch (zone.type) {
-        case RegionType::SUM: {
-            auto current_sum = std::accumulate(pips_in_zone.begin(), pips_in_zone.end(), 0);
-            if (current_sum > zone.target.value()) {
+        case RegionType::SUM:
+            if (new_sum > zone.target.value()) {
                 return false;
             }
-            if (is_zone_full && current_sum != zone.target.value()) {
+            if (is_zone_full && new_sum != zone.target.value()) {
                 return false;
             }
             break;
-        }
         case RegionType::GREATER:
-            if (is_zone_full && std::accumulate(pips_in_zone.begin(), pips_in_zone.end(), 0) <= zone.target.value()) {
+            if (is_zone_full && new_sum <= zone.target.value()) {
                 return false;
             }
             break;
         case RegionType::LESS:
-            if (is_zone_full && std::accumulate(pips_in_zone.begin(), pips_in_zone.end(), 0) >= zone.target.value()) {
+            if (is_zone_full && new_sum >= zone.target.value()) {
                 return false;
             }
             break;
         case RegionType::EQUALS:
-            if (std::ranges::adjacent_find(pips_in_zone, std::ranges::not_equal_to()) != pips_in_zone.end()) {
+            if (state.filled > 0 && pip != state.first) {
                 return false;
             }
-
             break;
         case RegionType::UNEQUAL:
-            if (pips_in_zone.size() > 1) {
-                auto sorted_pips = pips_in_zone;
-                std::ranges::sort(sorted_pips);
-                if (std::ranges::adjacent_find(sorted_pips) != sorted_pips.end()) {
-                    return false;
-                }
+            if (state.seen & (1u << pip)) {
+                return false;
             }
             break;
         case RegionType::EMPTY:
@@ -173,4 +1056,7 @@ bool Solver::check_zone_constraints(const Zone& zone) const
     }
     return true;
 }
+template class BasicSolver<64>;
+template class BasicSolver<MAX_BOARD_CELLS>;
+
 }  // namespace pips
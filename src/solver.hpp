@@ -1,36 +1,293 @@
 #pragma once
 
+#include <array>
+#include <memory>
 #include <optional>
+#include <stop_token>
+#include <tuple>
+#include <utility>
 #include <vector>
+#include "bitboard.hpp"
 #include "pips_game.hpp"
+#include "solver_engine.hpp"
+#include "solver_stats.hpp"
+#include "transposition_table.hpp"
 
 namespace pips {
 
-class Solver
+// Depth-first backtracking over bitboards, one domino per level. MaxCells bounds the boards it
+// accepts and sizes every per-cell table, so boards that fit in a single word search on
+// one-word bitboards; with_fitted_solver() picks the smallest instantiation for a game.
+template <std::size_t MaxCells>
+class BasicSolver final : public SolverEngine
 {
+    static_assert(MaxCells % 64 == 0 && MaxCells <= MAX_BOARD_CELLS, "whole bitboard words, at most MAX_BOARD_CELLS");
+
 public:
-    explicit Solver(const Game& game);
+    static constexpr std::size_t CAPACITY = MaxCells;
+
+    // Solvers of the same game and options may share `transpositions`, without one the solver
+    // makes its own when SolverOptions::transposition_bytes asks for it. The game's board must
+    // fit in CAPACITY cells.
+    explicit BasicSolver(const Game&                         game,
+                         SolverOptions                       options = {},
+                         std::shared_ptr<TranspositionTable> transpositions = nullptr);
+
+    using SolverEngine::solve;
+
+    // Searches from the current position, placements made with push() lead every solution.
+    // A node budget counts the nodes of this call only.
+    [[nodiscard]] SolveResult solve(const SolveLimits& limits, std::stop_token stop = {}) override;
+
+    // Counts from the current position and leaves it as it was before the call
+    SolutionCount count_solutions(std::size_t limit, std::stop_token stop = {}) override;
+
+    // Lays a domino on the board if both cells are free and its zones accept the pips
+    bool push(const DominoPlacement& placement);
+    // Takes back the last placement made with push()
+    void pop();
+    // Takes back placements, newest first, until `depth` are left. After a solve() that found a
+    // solution this also lifts the dominoes the search laid.
+    void pop_to(std::size_t depth);
+    // Placements on the board, pushed or laid by the last search
+    [[nodiscard]] std::size_t depth() const noexcept { return m_solution_placements.size(); }
 
-    [[nodiscard]] std::optional<std::vector<DominoPlacement>> solve();
+    // Placements the search would branch on from the current position, in search order
+    [[nodiscard]] std::vector<DominoPlacement> candidate_placements();
+
+    // Lets a running solve() give work away, only valid from its progress callback. The shallowest
+    // level of the search not split yet hands over the branches it has not tried: returns the
+    // placements down to and including the branch that level is in, empty when every level has
+    // split. The level stops once that branch is searched.
+    [[nodiscard]] std::vector<DominoPlacement> split_search();
+    // Placements a level branching on the first cell of `taken` tries after it, from the current
+    // position. With the path split_search() returned pushed but its last placement, these are the
+    // branches the split level gave away.
+    [[nodiscard]] std::vector<DominoPlacement> branches_after(const DominoPlacement& taken);
+
+    // Counts the current position as a search node that branched into `children`, for callers that
+    // expand it themselves, e.g. a parallel task handing its children out as subtasks
+    void count_expansion(std::size_t children);
+
+    // Shuffles the search order as SolverOptions::seed would, 0 restores reading order. Only from
+    // the empty board. Dead states and nogoods do not depend on the order, so restarts keep them.
+    void reseed(std::uint64_t seed);
+
+    // Search nodes visited by every solve() so far
+    [[nodiscard]] std::uint64_t nodes() const noexcept { return m_stats.nodes; }
+    // Search-tree statistics accumulated over every solve() so far
+    [[nodiscard]] const SolverStats& stats() const noexcept override { return m_stats; }
 
 private:
+    // Kernel microbenchmarks (bench/bench.cpp) time the private hot paths directly
+    friend class SolverBench;
+
+    using Board = BasicBitboard<MaxCells / 64>;
+
+    // Flat index of a cell, row * cols + col
+    using CellIndex = std::uint8_t;
+
+    // Set of pip values, bit v stands for pip v
+    using PipMask = std::uint8_t;
+    static constexpr PipMask ALL_PIPS = (1u << (MAX_PIP + 1)) - 1;
+
+    // Set of search depths, bit d stands for the placement made at depth d
+    using DepthMask = std::uint64_t;
+    static_assert(MaxCells / 2 <= 64, "one bit per placement");
+    // Conflict reported by a subtree that reached a solution, nothing above it may be jumped over
+    static constexpr DepthMask NOT_A_FAILURE = ~DepthMask{0};
+
+    // A placement inside a nogood: both cells and their pips, smaller cell first. 0 is never a literal.
+    using Literal = std::uint32_t;
+    static constexpr std::size_t MAX_NOGOOD_SIZE = 4;
+    static constexpr std::size_t NOGOOD_SLOTS = 4096;
+    // Placements that cannot all be on the board at once, literals[0] is the one that triggers the check
+    struct Nogood
+    {
+        std::array<Literal, MAX_NOGOOD_SIZE> literals{};
+    };
+
+    // Running aggregates of a zone, maintained by place() and remove()
+    struct ZoneState : ZoneFill
+    {
+        // Where the zone's pips so far sit in GameTables::ZoneAssignments::next_pips
+        std::uint16_t assignment = 0;
+        // Candidate pips for the zone's empty cells, see allowed_pips()
+        PipMask allowed = 0;
+    };
+
+    // Counts a search node, false once the search has been asked to stop or has run out of budget
+    bool enter_node();
+    // Whether the position is already known to have no solution
+    bool known_dead();
+    // Remembers the position as one with no solution, unless the search was stopped inside it
+    void record_dead();
     bool backtrack();
+    // Returns true to cut the search, once `limit` solutions are counted or on a stop request
+    bool count_backtrack(std::size_t limit, SolutionCount& result);
 
-    std::optional<GridCell> find_unoccupied_cell() const;
+    // Applies each legal placement at the next cell, or at `at`, in turn and calls visit() on it,
+    // stopping with the placement still applied as soon as visit() returns true
+    template <typename Visit>
+    bool for_each_branch(Visit&& visit, std::optional<CellIndex> at = std::nullopt);
+    // Position of a placement in the order for_each_branch() tries those covering its first cell
+    std::tuple<std::size_t, CellIndex, std::size_t> branch_rank(const DominoPlacement& placement) const;
 
-    bool check_zone_constraints(const Zone& zone) const;
+    std::optional<CellIndex> find_unoccupied_cell() const;
+    std::optional<CellIndex> find_most_constrained_cell();
 
-    const Game&                      m_game;
-    std::vector<std::vector<int8_t>> m_grid;
-    std::vector<bool>                m_used_dominoes;
-    // used to print the solution, not needed to solve
-    std::vector<DominoPlacement>          m_solution_placements;
-    std::vector<std::vector<const Zone*>> m_zone_lookup;
+    // Upper bound on the (domino, orientation) pairs that can still cover `cell`
+    std::uint8_t count_options(CellIndex cell, const Board& free) const;
+
+    // Whether adding `pip` to the zone keeps it consistent, the zone itself is left untouched
+    bool check_zone_constraints(std::uint8_t zone_id, std::uint8_t pip) const;
+
+    // Whether the zone with `pip` added still fits one of its assignments
+    bool fits_assignment(std::uint8_t zone_id, std::uint8_t pip) const;
+    // Pips an empty cell of the zone may take under an assignment the unused dominoes can complete
+    PipMask assignable_pips(std::uint8_t zone_id) const;
+
+    // Pips an empty cell of the zone may still take
+    PipMask allowed_pips(std::uint8_t zone_id) const;
+    void    refresh_allowed_pips(std::uint8_t zone_id);
+    // Checks every unfinished zone against the unused dominoes and narrows their candidate pips
+    bool propagate();
 
-    // Values in the grid, -2 since puzzles can have void spots
-    // -1 when no domino is placed, otherwise the value of the domino
-    static constexpr std::int8_t UNOCCUPIED = -1;
-    static constexpr std::int8_t HOLE = -2;
+    // Backjumping. Each failure is explained by the placements it depends on: those in the zone
+    // that rejected a pip, those covering a neighbour, those using up a domino kind. Bounds on the
+    // pip supply depend on every domino used, so failures they find blame every placement.
+    DepthMask placed_depths() const noexcept;
+    DepthMask explain_pip(CellIndex cell, std::uint8_t pip) const;
+    static Literal to_literal(CellIndex a, std::uint8_t pa, CellIndex b, std::uint8_t pb) noexcept;
+    Literal        to_literal(const DominoPlacement& placement) const noexcept;
+    bool           holds(Literal literal) const noexcept;
+    // Depths of the rest of a nogood that the placement just made completes, if any
+    std::optional<DepthMask> violated_nogood(Literal placed) const;
+    // Stores the placements at the depths of `conflict` as a nogood, if there are few enough
+    void learn_nogood(DepthMask conflict);
+
+    // Whether the position passes the checks the search makes after every placement
+    bool position_feasible();
+
+    // Region pruning. A domino covers one light and one dark square of the checkerboard, so a
+    // region of free cells cut off from the rest can only be tiled if it holds as many of each.
+    Board expand(const Board& cells) const noexcept;
+    // Whether covering the slot could split a region: its free neighbours lie on more than one
+    // run of free cells along the ring around it. Otherwise the region only loses a light and
+    // a dark cell and stays balanced.
+    bool may_split(CellIndex cell, CellIndex other, const Board& free) const;
+    // Whether each free region touching `seeds` stays balanced once `taken` is covered too. The
+    // occupied cells walling off an unbalanced region are added to `conflict`.
+    bool regions_tileable(const Board& taken, Board seeds, DepthMask& conflict) const;
+
+    // Statistics hooks, no-ops unless built with PIPS_SOLVER_STATS
+    void record_prune(std::uint8_t zone_id) noexcept;
+    void record_branching(std::size_t depth, std::size_t children);
+
+    void place(CellIndex cell, std::uint8_t pip);
+    void remove(CellIndex cell, std::uint8_t pip);
+
+    std::optional<std::size_t> find_kind(std::uint8_t p1, std::uint8_t p2) const;
+    void                       use_domino(std::size_t kind);
+    void                       release_domino(std::size_t kind);
+
+    // Zobrist keys of a pip on a cell and of the copies of a kind left unused
+    static std::uint64_t cell_key(CellIndex cell, std::uint8_t pip) noexcept;
+    std::uint64_t        kind_key(std::size_t kind) const noexcept;
+
+    CellIndex to_index(const GridCell& cell) const noexcept;
+    GridCell  to_cell(CellIndex idx) const noexcept;
+
+    Board free_cells() const noexcept { return ~(m_occupied | m_holes); }
+
+    const Game&   m_game;
+    SolverOptions m_options;
+    std::uint8_t  m_cols;
+    Board         m_occupied;
+    // Cells outside every zone, plus the padding bits past the end of the board
+    Board                              m_holes;
+    std::array<Board, MAX_PIP + 1>     m_pip_planes;
+    std::array<Board, MaxCells>        m_neighbors;
+    // The 10 cells around the horizontal and the vertical slot starting at each cell, in ring
+    // order so consecutive ones are neighbours. OFF_BOARD past an edge.
+    static constexpr CellIndex OFF_BOARD = 0xff;
+    std::array<std::array<std::array<CellIndex, 10>, 2>, MaxCells> m_rings;
+    // Light squares of the checkerboard, and the cells off the first and last columns
+    Board                              m_light;
+    Board                              m_not_first_col;
+    Board                              m_not_last_col;
+    std::vector<Board>                 m_zone_masks;
+    std::vector<ZoneState>             m_zone_states;
+    std::array<std::uint8_t, MaxCells> m_zone_of{};
+    // The search branches once per kind of domino rather than once per copy, trying them in
+    // m_kind_order. Equally constrained cells go to the lowest m_tie_rank. Both follow the game's
+    // order unless SolverOptions::seed shuffles them.
+    const std::vector<GameTables::Kind>& m_kinds;
+    std::vector<std::uint8_t>            m_kind_remaining;
+    std::vector<std::uint8_t>            m_kind_order;
+    std::array<std::uint8_t, MaxCells>   m_tie_rank{};
+    // Halves left on the unused dominoes, and the same packed
+    PipSupply             m_pip_supply;
+    GameTables::PipCounts m_supply_counts = 0;
+
+    // Most-constrained branching state. m_pair_counts[a][b] is the number of unused dominoes
+    // that can put a on one cell and b on its neighbour, m_pair_masks[a] the b's with a non-zero
+    // count. Option counts are cached per cell and recomputed once one of their inputs changes.
+    std::array<std::array<std::uint8_t, MAX_PIP + 1>, MAX_PIP + 1> m_pair_counts{};
+    std::array<PipMask, MAX_PIP + 1>                              m_pair_masks{};
+    // Each zone's cells together with their neighbours
+    std::vector<Board>                 m_zone_halos;
+    std::array<std::uint8_t, MaxCells> m_option_counts{};
+    Board                              m_dirty_options;
+
+    // Depth of the placement covering each cell, and the placements landing in each zone or
+    // using each domino kind
+    std::array<std::uint8_t, MaxCells> m_cover_depth{};
+    std::vector<DepthMask>             m_zone_depths;
+    std::vector<DepthMask>             m_kind_depths;
+    // Placements the last failed subtree depends on, its parent reads it to decide whether to jump
+    DepthMask           m_conflict = 0;
+    std::vector<Nogood> m_nogoods;
+
+    // Hash of the pips on the board and the unused dominoes, all a subtree's outcome depends on
+    std::uint64_t                       m_hash = 0;
+    std::shared_ptr<TranspositionTable> m_transpositions;
+
+    SearchLimiter m_limiter;
+    SolverStats   m_stats;
+
+    // Depth the running solve() started from, the levels that gave their remaining branches away
+    // and how many splits it has made. A subtree holding a split is not dead even when this search
+    // found nothing in it.
+    std::size_t   m_search_root = 0;
+    DepthMask     m_split_levels = 0;
+    std::uint64_t m_split_count = 0;
+
+    // used to print the solution, not needed to solve
+    std::vector<DominoPlacement> m_solution_placements;
 };
 
+extern template class BasicSolver<64>;
+extern template class BasicSolver<MAX_BOARD_CELLS>;
+
+// Handles every board up to MAX_BOARD_CELLS
+using Solver = BasicSolver<MAX_BOARD_CELLS>;
+// One-word bitboards, for boards of up to 64 cells
+using CompactSolver = BasicSolver<64>;
+
+// Calls `visit` with a solver of the smallest instantiation the game's board fits in
+template <typename Visit>
+decltype(auto) with_fitted_solver(const Game&                         game,
+                                  SolverOptions                       options,
+                                  std::shared_ptr<TranspositionTable> transpositions,
+                                  Visit&&                             visit)
+{
+    if (static_cast<std::size_t>(game.dim.rows) * game.dim.cols <= CompactSolver::CAPACITY) {
+        CompactSolver solver(game, options, std::move(transpositions));
+        return visit(solver);
+    }
+    Solver solver(game, options, std::move(transpositions));
+    return visit(solver);
+}
+
 }  // namespace pips
@@ -0,0 +1,320 @@
+#include "solver_daemon.hpp"
+
+#include "pips_data.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pips {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Fixed pool of threads running queued jobs. submit() blocks while the queue is full, so a client
+// sending faster than games are solved is held back rather than buffered without bound.
+class JobQueue
+{
+public:
+    using Job = std::function<void()>;
+
+    explicit JobQueue(unsigned threads) : m_capacity(threads * JOBS_PER_THREAD)
+    {
+        for (unsigned t = 0; t < threads; ++t) {
+            m_workers.emplace_back([this] { work(); });
+        }
+    }
+
+    // Runs every job still queued before the workers leave
+    ~JobQueue()
+    {
+        {
+            std::scoped_lock lock(m_mutex);
+            m_closing = true;
+        }
+        m_ready.notify_all();
+    }
+
+    void submit(Job job)
+    {
+        std::unique_lock lock(m_mutex);
+        m_space.wait(lock, [this] { return m_jobs.size() < m_capacity; });
+        m_jobs.push_back(std::move(job));
+        lock.unlock();
+        m_ready.notify_one();
+    }
+
+private:
+    static constexpr std::size_t JOBS_PER_THREAD = 4;
+
+    void work()
+    {
+        for (;;) {
+            std::unique_lock lock(m_mutex);
+            m_ready.wait(lock, [this] { return !m_jobs.empty() || m_closing; });
+            if (m_jobs.empty())
+                return;
+            auto job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+            lock.unlock();
+            m_space.notify_one();
+            job();
+        }
+    }
+
+    std::size_t             m_capacity;
+    std::mutex              m_mutex;
+    std::condition_variable m_ready;
+    std::condition_variable m_space;
+    std::deque<Job>         m_jobs;
+    bool                    m_closing = false;
+    // Last, so the workers are joined before the queue they drain goes away
+    std::vector<std::jthread> m_workers;
+};
+
+// A client's request stream and the answers going back to it, closed once the reader and every
+// job answering one of its requests are done with it
+class Connection
+{
+public:
+    Connection(int in_fd, int out_fd, bool owned) : m_in(in_fd), m_out(out_fd), m_owned(owned) {}
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    ~Connection()
+    {
+        if (m_owned)
+            ::close(m_in);
+    }
+
+    // The next line without its newline, false once the input is exhausted
+    bool read_line(std::string& line)
+    {
+        for (;;) {
+            if (const auto newline = m_buffer.find('\n', m_scanned); newline != std::string::npos) {
+                line.assign(m_buffer, 0, newline);
+                m_buffer.erase(0, newline + 1);
+                m_scanned = 0;
+                return true;
+            }
+            m_scanned = m_buffer.size();
+
+            std::array<char, READ_CHUNK> chunk;
+            const auto                   read = ::read(m_in, chunk.data(), chunk.size());
+            if (read < 0 && errno == EINTR)
+                continue;
+            if (read <= 0) {
+                // A last request without a newline still counts
+                if (m_buffer.empty())
+                    return false;
+                line = std::move(m_buffer);
+                m_buffer.clear();
+                m_scanned = 0;
+                return true;
+            }
+            m_buffer.append(chunk.data(), static_cast<std::size_t>(read));
+        }
+    }
+
+    // Writes `line` and a newline in one piece, answers finishing together never interleave. Once
+    // the client has gone away the answers are dropped.
+    void write_line(std::string line)
+    {
+        line.push_back('\n');
+        std::scoped_lock lock(m_write_mutex);
+        for (std::size_t written = 0; written < line.size() && !m_broken;) {
+            const auto count = ::write(m_out, line.data() + written, line.size() - written);
+            if (count >= 0)
+                written += static_cast<std::size_t>(count);
+            else if (errno != EINTR)
+                m_broken = true;
+        }
+    }
+
+private:
+    static constexpr std::size_t READ_CHUNK = 64 * 1024;
+
+    int         m_in;
+    int         m_out;
+    bool        m_owned;
+    std::string m_buffer;
+    // Bytes of m_buffer already known to hold no newline
+    std::size_t m_scanned = 0;
+
+    std::mutex m_write_mutex;
+    bool       m_broken = false;
+};
+
+// What the readers of every connection share, kept alive by whichever of them runs last
+struct DaemonState
+{
+    explicit DaemonState(const DaemonOptions& daemon_options)
+        : options(daemon_options), jobs(std::max(options.threads != 0 ? options.threads
+                                                                      : std::thread::hardware_concurrency(),
+                                                 1u))
+    {
+    }
+
+    DaemonOptions options;
+    // Last, so the jobs still queued are answered before the options go away
+    JobQueue jobs;
+};
+
+// The solution in the shape of the puzzle's "solution" field: entry i holds the cells of
+// dominoes[i], the cell of its first pip first
+nlohmann::json solution_json(const Game& game, const std::vector<DominoPlacement>& solution)
+{
+    nlohmann::json    cells = nlohmann::json::array();
+    std::vector<bool> used(solution.size());
+    for (const auto& domino : game.dominoes) {
+        for (std::size_t i = 0; i < solution.size(); ++i) {
+            auto first = solution[i].placement1;
+            auto second = solution[i].placement2;
+            if (first.pip != domino.p1)
+                std::swap(first, second);
+            if (used[i] || first.pip != domino.p1 || second.pip != domino.p2)
+                continue;
+            used[i] = true;
+            cells.push_back({{first.cell.row, first.cell.col}, {second.cell.row, second.cell.col}});
+            break;
+        }
+    }
+    return cells;
+}
+
+std::string error_answer(std::size_t line, std::string_view error)
+{
+    return nlohmann::json{{"line", line}, {"status", "error"}, {"error", error}}.dump();
+}
+
+std::string answer(const std::string& request, std::size_t line, const DaemonOptions& options)
+{
+    const auto game = NytJsonProvider::parse_game(request);
+    if (!game)
+        return error_answer(line, game.error());
+
+    nlohmann::json answer = {{"line", line}};
+
+    // Requests already run one per thread, each engine searches on its own
+    const auto  solver = make_engine(options.engine, *game, options.options);
+    const auto  start = Clock::now();
+    SolveLimits limits{.node_budget = options.node_budget};
+    if (options.time_limit.count() > 0) {
+        limits.deadline = start + options.time_limit;
+    }
+    const auto                          result = solver->solve(limits);
+    const std::chrono::duration<double> seconds = Clock::now() - start;
+
+    answer["status"] = to_string(result.status);
+    if (result.solution) {
+        answer["solution"] = solution_json(*game, *result.solution);
+    }
+    if (!result.configuration.empty()) {
+        answer["configuration"] = result.configuration;
+    }
+    answer["seconds"] = seconds.count();
+    answer["stats"] = solver->stats();
+    return answer.dump();
+}
+
+// Queues every request of the connection until its input ends
+void serve(const std::shared_ptr<Connection>& connection, DaemonState& state)
+{
+    std::string request;
+    for (std::size_t line = 1; connection->read_line(request); ++line) {
+        if (request.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+        // A request the solver chokes on gets an error answer, it never takes the daemon down
+        state.jobs.submit([connection, &state, line, request = std::move(request)] {
+            std::string reply;
+            try {
+                reply = answer(request, line, state.options);
+            } catch (const std::exception& ex) {
+                reply = error_answer(line, ex.what());
+            } catch (...) {
+                reply = error_answer(line, "internal error");
+            }
+            connection->write_line(std::move(reply));
+        });
+    }
+}
+
+std::expected<void, std::string> serve_socket(const std::filesystem::path& path, std::shared_ptr<DaemonState> state)
+{
+    const auto fail = [&](std::string_view reason) {
+        return std::unexpected(path.string() + ": " + std::string(reason));
+    };
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    const std::string native = path.string();
+    if (native.size() >= sizeof(address.sun_path))
+        return fail("socket path too long");
+    std::ranges::copy(native, address.sun_path);
+
+    const int listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0)
+        return fail(std::strerror(errno));
+
+    // A socket left behind by a daemon that did not shut down cleanly would fail the bind
+    std::error_code ec;
+    if (std::filesystem::is_socket(path, ec))
+        std::filesystem::remove(path, ec);
+
+    if (::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listener, SOMAXCONN) != 0) {
+        const int error = errno;
+        ::close(listener);
+        return fail(std::strerror(error));
+    }
+
+    for (;;) {
+        const int client = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            const int error = errno;
+            ::close(listener);
+            return fail(std::strerror(error));
+        }
+        // Each connection gets a reader, its requests join the shared queue
+        std::thread([state, connection = std::make_shared<Connection>(client, client, true)] {
+            serve(connection, *state);
+        }).detach();
+    }
+}
+
+}  // namespace
+
+std::expected<void, std::string> run_daemon(const DaemonOptions& options)
+{
+    // A client hanging up makes its writes fail instead of killing the daemon
+    std::signal(SIGPIPE, SIG_IGN);
+
+    auto state = std::make_shared<DaemonState>(options);
+    if (options.socket) {
+        return serve_socket(*options.socket, std::move(state));
+    }
+
+    serve(std::make_shared<Connection>(STDIN_FILENO, STDOUT_FILENO, false), *state);
+    return {};
+}
+
+}  // namespace pips
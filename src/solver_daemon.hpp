@@ -0,0 +1,38 @@
+#pragma once
+
+#include "solver_engine.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+namespace pips {
+
+// How the daemon solves the games it is sent
+struct DaemonOptions
+{
+    // Requests solved at once, 0 uses every hardware thread
+    unsigned      threads = 0;
+    EngineKind    engine = EngineKind::BACKTRACKING;
+    SolverOptions options;
+    // Limits of each game, 0 for none
+    std::chrono::milliseconds time_limit{};
+    std::uint64_t             node_budget = 0;
+    // Listen on this Unix socket instead of serving stdin
+    std::optional<std::filesystem::path> socket;
+};
+
+// Serves solve requests until stdin is closed, or for as long as the socket accepts connections.
+// Every request is one line holding a game object, as read by NytJsonProvider::parse_game. Every
+// answer is one JSON line:
+//   {"line": N, "status": "solved", "solution": [[[row, col], [row, col]], ...], "seconds": ..., "stats": {...}}
+// where the solution has the shape of the puzzle's "solution" field, and a line that is not a
+// valid game gets {"line": N, "status": "error", "error": "..."}. Requests are solved concurrently
+// on a pool of threads, so answers come back in the order they finish; `line` numbers the request
+// within its connection, from 1.
+std::expected<void, std::string> run_daemon(const DaemonOptions& options);
+
+}  // namespace pips
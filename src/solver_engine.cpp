@@ -0,0 +1,117 @@
+#include "solver_engine.hpp"
+
+#include "dlx_solver.hpp"
+#include "parallel_solver.hpp"
+#include "portfolio_solver.hpp"
+
+#include <algorithm>
+
+namespace pips {
+
+std::optional<EngineKind> parse_engine_kind(std::string_view name)
+{
+    if (name == "backtrack")
+        return EngineKind::BACKTRACKING;
+    if (name == "dlx")
+        return EngineKind::DANCING_LINKS;
+    if (name == "portfolio")
+        return EngineKind::PORTFOLIO;
+    return std::nullopt;
+}
+
+std::string_view to_string(EngineKind kind)
+{
+    switch (kind) {
+        case EngineKind::BACKTRACKING:
+            return "backtrack";
+        case EngineKind::DANCING_LINKS:
+            return "dlx";
+        case EngineKind::PORTFOLIO:
+            return "portfolio";
+    }
+    return "unknown";
+}
+
+std::string_view to_string(SolveStatus status)
+{
+    switch (status) {
+        case SolveStatus::SOLVED:
+            return "solved";
+        case SolveStatus::UNSATISFIABLE:
+            return "unsat";
+        case SolveStatus::TIMED_OUT:
+            return "timeout";
+        case SolveStatus::CANCELLED:
+            return "cancelled";
+    }
+    return "unknown";
+}
+
+void SearchLimiter::start(const SolveLimits& limits, std::stop_token stop, std::uint64_t nodes)
+{
+    m_limits = limits;
+    m_stop = std::move(stop);
+    m_status = SolveStatus::UNSATISFIABLE;
+    m_start_nodes = nodes;
+    if (m_limits.deadline || m_limits.on_progress)
+        m_start = SolveLimits::Clock::now();
+
+    // The node count is bumped before admit(), node n of the search sees start + n
+    m_budget_end = m_limits.node_budget != 0 ? nodes + m_limits.node_budget + 1 : NEVER;
+    m_next_progress = m_limits.on_progress ? nodes + std::max<std::uint64_t>(m_limits.progress_interval, 1) : NEVER;
+    // A deadline already passed stops the search at its first node
+    m_next_check = std::min({m_budget_end, m_next_progress, m_limits.deadline ? nodes : NEVER});
+}
+
+bool SearchLimiter::checkpoint(std::uint64_t nodes, std::size_t depth)
+{
+    const auto cut = [this](SolveStatus status) {
+        if (m_status == SolveStatus::UNSATISFIABLE)
+            m_status = status;
+        // Every later admit() comes back here and is refused
+        m_next_check = 0;
+        return false;
+    };
+
+    if (m_status != SolveStatus::UNSATISFIABLE)
+        return false;
+    if (m_stop.stop_requested())
+        return cut(SolveStatus::CANCELLED);
+    if (nodes >= m_budget_end)
+        return cut(SolveStatus::TIMED_OUT);
+
+    if (m_limits.deadline || m_limits.on_progress) {
+        const auto now = SolveLimits::Clock::now();
+        if (m_limits.deadline && now >= *m_limits.deadline)
+            return cut(SolveStatus::TIMED_OUT);
+        if (nodes >= m_next_progress) {
+            m_limits.on_progress({.nodes = nodes - m_start_nodes, .depth = depth, .elapsed = now - m_start});
+            m_next_progress = nodes + std::max<std::uint64_t>(m_limits.progress_interval, 1);
+        }
+    }
+
+    m_next_check = std::min({m_budget_end, m_next_progress, m_limits.deadline ? nodes + DEADLINE_POLL_NODES : NEVER});
+    return true;
+}
+
+SolveStatus SearchLimiter::status() const noexcept
+{
+    if (m_status != SolveStatus::UNSATISFIABLE)
+        return m_status;
+    return m_stop.stop_requested() ? SolveStatus::CANCELLED : SolveStatus::UNSATISFIABLE;
+}
+
+std::unique_ptr<SolverEngine> make_engine(EngineKind kind, const Game& game, SolverOptions options, unsigned threads)
+{
+    switch (kind) {
+        case EngineKind::BACKTRACKING:
+            return std::make_unique<ParallelSolver>(game, options, threads);
+        case EngineKind::DANCING_LINKS:
+            return std::make_unique<DlxSolver>(game);
+        case EngineKind::PORTFOLIO:
+            return std::make_unique<PortfolioSolver>(game, options, threads);
+    }
+    return nullptr;
+}
+
+}  // namespace pips
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "pips_game.hpp"
+#include "solver_stats.hpp"
+
+namespace pips {
+
+// How backtrack() picks the next cell to cover
+enum class BranchingHeuristic {
+    ROW_MAJOR,         // first free cell in reading order
+    MOST_CONSTRAINED,  // free cell with the fewest legal (domino, orientation) options
+};
+
+// Tuning of the backtracking search, the dancing-links engine has no knobs and ignores it
+struct SolverOptions
+{
+    BranchingHeuristic branching = BranchingHeuristic::MOST_CONSTRAINED;
+    // Bound every unfinished zone by the pips left on the unused dominoes after each placement
+    bool forward_checking = true;
+    // Memory cap of the table remembering dead search states, 0 turns it off
+    std::size_t transposition_bytes = 0;
+    // On a failure, jump back to the latest placement it depends on rather than the previous one,
+    // and learn the small sets of placements that can never appear together
+    bool backjumping = true;
+    // Reject a placement that cuts off a region of free cells no set of dominoes could tile
+    bool region_pruning = true;
+    // Keep each zone to the pip counts left by sharing the dominoes' halves out among all zones
+    // before the search, see GameTables::zone_assignments
+    bool zone_assignments = true;
+    // Non-zero shuffles the ties between equally constrained cells and the order domino kinds are
+    // tried in, so runs with different seeds walk the tree differently. 0 keeps reading order.
+    std::uint64_t seed = 0;
+};
+
+struct SolutionCount
+{
+    std::size_t count = 0;
+    // The whole tree was searched, so `count` is every solution rather than the first few
+    bool complete = false;
+    // One of the solutions counted matches Game::official_solution
+    bool official_found = false;
+
+    [[nodiscard]] bool unique() const noexcept { return complete && count == 1; }
+};
+
+enum class SolveStatus {
+    SOLVED,
+    UNSATISFIABLE,  // the whole tree was searched without a solution
+    TIMED_OUT,      // the deadline passed or the node budget ran out first
+    CANCELLED,      // the stop token was triggered first
+};
+
+[[nodiscard]] std::string_view to_string(SolveStatus status);
+
+struct SolveProgress
+{
+    std::uint64_t                 nodes = 0;
+    std::size_t                   depth = 0;
+    std::chrono::duration<double> elapsed{};
+};
+
+// Bounds on one solve() call, the default places none
+struct SolveLimits
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::optional<Clock::time_point> deadline;
+    // Search nodes the call may visit, 0 for no budget
+    std::uint64_t node_budget = 0;
+    // Called on the solving thread every `progress_interval` nodes
+    std::function<void(const SolveProgress&)> on_progress;
+    std::uint64_t                             progress_interval = 1 << 20;
+
+    [[nodiscard]] static SolveLimits within(std::chrono::steady_clock::duration time_limit)
+    {
+        return {.deadline = Clock::now() + time_limit};
+    }
+};
+
+struct SolveResult
+{
+    SolveStatus                                 status = SolveStatus::UNSATISFIABLE;
+    std::optional<std::vector<DominoPlacement>> solution;
+    // Configuration that settled the outcome, for engines racing several; empty otherwise
+    std::string configuration;
+};
+
+// Enforces SolveLimits and the stop token inside an engine's search. admit() runs on every node
+// but only reads the clock, checks the budget or reports progress once the node count reaches the
+// next checkpoint, so a search without limits pays one comparison next to the stop check.
+class SearchLimiter
+{
+public:
+    // Starts a search whose node counter currently reads `nodes`
+    void start(const SolveLimits& limits, std::stop_token stop, std::uint64_t nodes);
+
+    // False once the search has to stop, and on every call after that
+    [[nodiscard]] bool admit(std::uint64_t nodes, std::size_t depth)
+    {
+        if (nodes < m_next_check) [[likely]]
+            return !m_stop.stop_requested();
+        return checkpoint(nodes, depth);
+    }
+
+    // Whether admit() cut the search short, its subtrees were not fully searched
+    [[nodiscard]] bool interrupted() const noexcept
+    {
+        return m_status != SolveStatus::UNSATISFIABLE || m_stop.stop_requested();
+    }
+    // Outcome of a search that found no solution
+    [[nodiscard]] SolveStatus status() const noexcept;
+
+private:
+    // How often the deadline is compared against the clock
+    static constexpr std::uint64_t DEADLINE_POLL_NODES = 64;
+    static constexpr std::uint64_t NEVER = std::numeric_limits<std::uint64_t>::max();
+
+    bool checkpoint(std::uint64_t nodes, std::size_t depth);
+
+    SolveLimits                    m_limits;
+    std::stop_token                m_stop;
+    SolveLimits::Clock::time_point m_start;
+    std::uint64_t                  m_start_nodes = 0;
+    std::uint64_t                  m_budget_end = NEVER;
+    std::uint64_t                  m_next_progress = NEVER;
+    std::uint64_t                  m_next_check = NEVER;
+    // UNSATISFIABLE while the search runs, why it was cut once it is
+    SolveStatus m_status = SolveStatus::UNSATISFIABLE;
+};
+
+// Search backend shared by every engine, so callers can pick one at run time
+class SolverEngine
+{
+public:
+    virtual ~SolverEngine() = default;
+
+    // Searches until a solution is found, the tree is exhausted, a limit is hit or `stop` is
+    // requested; the status tells which
+    [[nodiscard]] virtual SolveResult solve(const SolveLimits& limits, std::stop_token stop = {}) = 0;
+
+    // Unlimited search, returns early with no solution once `stop` is requested
+    [[nodiscard]] std::optional<std::vector<DominoPlacement>> solve(std::stop_token stop = {})
+    {
+        return solve(SolveLimits{}, std::move(stop)).solution;
+    }
+
+    // Keeps searching past the first solution until `limit` are found, a limit of 2 is enough to
+    // tell whether the puzzle is unique
+    virtual SolutionCount count_solutions(std::size_t limit, std::stop_token stop = {}) = 0;
+
+    [[nodiscard]] virtual const SolverStats& stats() const noexcept = 0;
+};
+
+enum class EngineKind {
+    BACKTRACKING,   // Solver, or ParallelSolver on more than one thread
+    DANCING_LINKS,  // DlxSolver
+    PORTFOLIO,      // PortfolioSolver racing both, and randomized restarts
+};
+
+[[nodiscard]] std::optional<EngineKind> parse_engine_kind(std::string_view name);
+[[nodiscard]] std::string_view          to_string(EngineKind kind);
+
+// `threads` applies to the backtracking engine and sizes the portfolio, 0 uses every hardware thread
+[[nodiscard]] std::unique_ptr<SolverEngine> make_engine(EngineKind    kind,
+                                                        const Game&   game,
+                                                        SolverOptions options = {},
+                                                        unsigned      threads = 1);
+
+}  // namespace pips
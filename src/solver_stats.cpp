@@ -0,0 +1,77 @@
+#include "solver_stats.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <string_view>
+
+namespace pips {
+
+namespace {
+
+std::string_view region_key(std::size_t type)
+{
+    static constexpr std::array<std::string_view, 6> keys = {"empty", "equals", "sum", "less", "greater", "unequal"};
+    return keys[type];
+}
+
+}  // namespace
+
+void SolverStats::record_branching(std::size_t depth, std::size_t children)
+{
+    if (branching.size() <= depth)
+        branching.resize(depth + 1);
+    auto& histogram = branching[depth];
+    if (histogram.size() <= children)
+        histogram.resize(children + 1);
+    histogram[children]++;
+}
+
+void SolverStats::merge(const SolverStats& other)
+{
+    nodes += other.nodes;
+    backtracks += other.backtracks;
+    max_depth = std::max(max_depth, other.max_depth);
+    for (std::size_t i = 0; i < prunes_by_region.size(); ++i) {
+        prunes_by_region[i] += other.prunes_by_region[i];
+    }
+    dead_cells += other.dead_cells;
+    transposition_hits += other.transposition_hits;
+    transposition_misses += other.transposition_misses;
+    backjumped_levels += other.backjumped_levels;
+    nogood_prunes += other.nogood_prunes;
+    region_prunes += other.region_prunes;
+
+    for (std::size_t depth = 0; depth < other.branching.size(); ++depth) {
+        for (std::size_t children = 0; children < other.branching[depth].size(); ++children) {
+            if (const auto count = other.branching[depth][children]; count != 0) {
+                record_branching(depth, children);
+                branching[depth][children] += count - 1;
+            }
+        }
+    }
+}
+
+void to_json(nlohmann::json& json, const SolverStats& stats)
+{
+    json = {{"nodes", stats.nodes}};
+    if (!SolverStats::ENABLED)
+        return;
+
+    nlohmann::json prunes = nlohmann::json::object();
+    for (std::size_t type = 0; type < stats.prunes_by_region.size(); ++type) {
+        prunes[std::string(region_key(type))] = stats.prunes_by_region[type];
+    }
+
+    json["backtracks"] = stats.backtracks;
+    json["max_depth"] = stats.max_depth;
+    json["prunes_by_region"] = std::move(prunes);
+    json["dead_cells"] = stats.dead_cells;
+    json["transposition"] = {{"hits", stats.transposition_hits}, {"misses", stats.transposition_misses}};
+    json["backjumped_levels"] = stats.backjumped_levels;
+    json["nogood_prunes"] = stats.nogood_prunes;
+    json["region_prunes"] = stats.region_prunes;
+    json["branching_by_depth"] = stats.branching;
+}
+
+}  // namespace pips
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "pips_game.hpp"
+
+#include <nlohmann/json_fwd.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace pips {
+
+// Search-tree statistics gathered by Solver. Everything but the node count is only collected
+// when the build defines PIPS_SOLVER_STATS, otherwise the recording code compiles away.
+struct SolverStats
+{
+#ifdef PIPS_SOLVER_STATS
+    static constexpr bool ENABLED = true;
+#else
+    static constexpr bool ENABLED = false;
+#endif
+
+    std::uint64_t nodes = 0;
+    // Placements taken back after their subtree failed
+    std::uint64_t backtracks = 0;
+    std::uint32_t max_depth = 0;
+    // Candidate placements rejected by a zone, indexed by its RegionType
+    std::array<std::uint64_t, 6> prunes_by_region{};
+    // Nodes left with a free cell that no remaining domino can cover
+    std::uint64_t dead_cells = 0;
+    // Positions looked up in the transposition table, and how many were already known dead
+    std::uint64_t transposition_hits = 0;
+    std::uint64_t transposition_misses = 0;
+    // Levels skipped by backjumping, and placements cut by a learned nogood
+    std::uint64_t backjumped_levels = 0;
+    std::uint64_t nogood_prunes = 0;
+    // Placements rejected for leaving a region of free cells that dominoes cannot tile
+    std::uint64_t region_prunes = 0;
+    // branching[depth][b] counts the nodes at `depth` that explored b children
+    std::vector<std::vector<std::uint64_t>> branching;
+
+    void record_prune(RegionType type) noexcept { prunes_by_region[static_cast<std::size_t>(type)]++; }
+    void record_branching(std::size_t depth, std::size_t children);
+
+    // Adds up the statistics of another search, e.g. one worker of a parallel solve
+    void merge(const SolverStats& other);
+};
+
+void to_json(nlohmann::json& json, const SolverStats& stats);
+
+}  // namespace pips
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pips {
+
+// Zobrist key number `i`, a splitmix64 step so keys need no table and are the same in every run
+constexpr std::uint64_t zobrist_key(std::uint64_t i) noexcept
+{
+    std::uint64_t z = (i + 1) * 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// Fixed-size set of search states known to have no solution, keyed by their Zobrist hash.
+// Direct-mapped, a new state simply overwrites whatever shared its slot. Slots are relaxed
+// atomics, so threads searching the same game can share one table without locking.
+class TranspositionTable
+{
+public:
+    // Rounds `max_bytes` down to a power of two of slots, under one slot the table stays empty
+    explicit TranspositionTable(std::size_t max_bytes)
+        : m_slots(max_bytes < sizeof(Slot) ? 0 : std::bit_floor(max_bytes / sizeof(Slot)))
+    {
+    }
+
+    [[nodiscard]] bool contains(std::uint64_t hash) const noexcept
+    {
+        return !m_slots.empty() && m_slots[slot_of(hash)].load(std::memory_order_relaxed) == stored(hash);
+    }
+
+    void insert(std::uint64_t hash) noexcept
+    {
+        if (!m_slots.empty())
+            m_slots[slot_of(hash)].store(stored(hash), std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] std::size_t bytes() const noexcept { return m_slots.size() * sizeof(Slot); }
+
+private:
+    using Slot = std::atomic<std::uint64_t>;
+
+    std::size_t slot_of(std::uint64_t hash) const noexcept { return hash & (m_slots.size() - 1); }
+    // Zero marks an empty slot, the one state that hashes to it is stored as 1
+    static std::uint64_t stored(std::uint64_t hash) noexcept { return hash != 0 ? hash : 1; }
+
+    std::vector<Slot> m_slots;
+};
+
+}  // namespace pips
@@ -0,0 +1,328 @@
+// Counts the solutions of random solvable boards under every combination of search options and
+// checks that they all agree. Pruning and branching choices may change how the tree is walked,
+// never what is in it. The parallel search and hint re-solves of each board, and of a copy made
+// unsolvable, must settle it the way the counts do.
+
+#include "hint_solver.hpp"
+#include "parallel_solver.hpp"
+#include "pips_game.hpp"
+#include "solver.hpp"
+#include "solver_engine.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <format>
+#include <functional>
+#include <print>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr unsigned    BOARDS = 300;
+constexpr std::size_t COUNT_LIMIT = 5'000;
+constexpr unsigned    PARALLEL_THREADS = 4;
+constexpr std::size_t TABLE_BYTES = 1 << 16;
+
+// Every pruning off, the reference the other searches are compared against
+constexpr pips::SolverOptions PLAINEST = {.branching = pips::BranchingHeuristic::ROW_MAJOR,
+                                          .forward_checking = false,
+                                          .backjumping = false,
+                                          .region_pruning = false,
+                                          .zone_assignments = false};
+
+// A board tiled by random dominoes, cut into random zones whose rules the tiling meets
+pips::Game random_game(std::mt19937& rng)
+{
+    const auto uniform = [&](int low, int high) { return std::uniform_int_distribution<int>(low, high)(rng); };
+
+    pips::Game game;
+    game.dim = {static_cast<std::uint8_t>(uniform(2, 5)), static_cast<std::uint8_t>(uniform(2, 5))};
+    const int rows = game.dim.rows;
+    const int cols = game.dim.cols;
+
+    // Pair each cell with a random free neighbour, a cell left without one becomes a hole
+    std::vector<int> pip_of(rows * cols, -1);
+    std::vector<int> order(rows * cols);
+    for (int cell = 0; cell < rows * cols; ++cell) {
+        order[cell] = cell;
+    }
+    std::ranges::shuffle(order, rng);
+    for (const int cell : order) {
+        if (pip_of[cell] != -1)
+            continue;
+        std::vector<int> partners;
+        if (cell % cols + 1 < cols && pip_of[cell + 1] == -1)
+            partners.push_back(cell + 1);
+        if (cell % cols > 0 && pip_of[cell - 1] == -1)
+            partners.push_back(cell - 1);
+        if (cell + cols < rows * cols && pip_of[cell + cols] == -1)
+            partners.push_back(cell + cols);
+        if (cell >= cols && pip_of[cell - cols] == -1)
+            partners.push_back(cell - cols);
+        if (partners.empty() || uniform(0, 9) == 0) {
+            pip_of[cell] = -2;
+            continue;
+        }
+        const int other = partners[uniform(0, static_cast<int>(partners.size()) - 1)];
+        // Few pip values make for many interchangeable dominoes and many solutions
+        pip_of[cell] = uniform(0, 3);
+        pip_of[other] = uniform(0, 3);
+        game.dominoes.push_back({static_cast<std::uint8_t>(pip_of[cell]), static_cast<std::uint8_t>(pip_of[other])});
+    }
+
+    // Zones grow from a random cell over free neighbours, then take the rule their pips meet
+    std::vector<bool> zoned(rows * cols);
+    for (const int seed : order) {
+        if (pip_of[seed] < 0 || zoned[seed])
+            continue;
+        pips::Zone       zone{.type = pips::RegionType::EMPTY};
+        std::vector<int> cells = {seed};
+        zoned[seed] = true;
+        for (int size = uniform(1, 4); static_cast<int>(cells.size()) < size;) {
+            const int from = cells[uniform(0, static_cast<int>(cells.size()) - 1)];
+            const int to = from + std::array{1, -1, cols, -cols}[uniform(0, 3)];
+            const bool wraps = (to == from + 1 && to % cols == 0) || (to == from - 1 && from % cols == 0);
+            if (to < 0 || to >= rows * cols || wraps || pip_of[to] < 0 || zoned[to]) {
+                if (uniform(0, 3) == 0)
+                    break;
+                continue;
+            }
+            zoned[to] = true;
+            cells.push_back(to);
+        }
+
+        int              sum = 0;
+        std::vector<int> pips;
+        for (const int cell : cells) {
+            zone.indices.push_back({static_cast<std::uint8_t>(cell / cols), static_cast<std::uint8_t>(cell % cols)});
+            sum += pip_of[cell];
+            pips.push_back(pip_of[cell]);
+        }
+        std::ranges::sort(pips);
+        switch (uniform(0, 5)) {
+            case 0:
+                zone.type = pips::RegionType::SUM;
+                zone.target = static_cast<std::uint8_t>(sum);
+                break;
+            case 1:
+                zone.type = pips::RegionType::LESS;
+                zone.target = static_cast<std::uint8_t>(sum + uniform(1, 3));
+                break;
+            case 2:
+                if (sum > 0) {
+                    zone.type = pips::RegionType::GREATER;
+                    zone.target = static_cast<std::uint8_t>(sum - uniform(1, sum));
+                }
+                break;
+            case 3:
+                if (pips.front() == pips.back())
+                    zone.type = pips::RegionType::EQUALS;
+                break;
+            case 4:
+                if (std::ranges::adjacent_find(pips) == pips.end())
+                    zone.type = pips::RegionType::UNEQUAL;
+                break;
+            default:
+                break;
+        }
+        game.zones.push_back(std::move(zone));
+    }
+
+    game.tables = pips::build_tables(game);
+    return game;
+}
+
+std::string describe(const pips::SolverOptions& options)
+{
+    auto name = std::format("{} fc={} backjump={} parity={} assign={}",
+                            options.branching == pips::BranchingHeuristic::MOST_CONSTRAINED ? "most-constrained"
+                                                                                             : "row-major",
+                            options.forward_checking,
+                            options.backjumping,
+                            options.region_pruning,
+                            options.zone_assignments);
+    if (options.transposition_bytes != 0)
+        name += " table";
+    if (options.seed != 0)
+        name += std::format(" seed={}", options.seed);
+    return name;
+}
+
+struct Configuration
+{
+    std::string                                           name;
+    std::function<pips::SolutionCount(const pips::Game&)> count;
+};
+
+Configuration engine_configuration(pips::EngineKind engine, const pips::SolverOptions& options)
+{
+    return {engine == pips::EngineKind::BACKTRACKING ? describe(options) : std::string(pips::to_string(engine)),
+            [=](const pips::Game& game) {
+                return pips::make_engine(engine, game, options)->count_solutions(COUNT_LIMIT);
+            }};
+}
+
+// A solution holds when a fresh solver takes every placement in turn and no domino is left over
+bool valid_solution(const pips::Game& game, std::span<const pips::DominoPlacement> solution)
+{
+    pips::Solver checker(game);
+    return solution.size() == game.dominoes.size() &&
+           std::ranges::all_of(solution, [&](const auto& placement) { return checker.push(placement); });
+}
+
+bool same_placement(const pips::DominoPlacement& a, const pips::DominoPlacement& b)
+{
+    return a.placement1.cell == b.placement1.cell && a.placement1.pip == b.placement1.pip &&
+           a.placement2.cell == b.placement2.cell && a.placement2.pip == b.placement2.pip;
+}
+
+// Checks a solve() outcome against the reference count, returns what is wrong or an empty string
+std::string check_result(const pips::Game& game, const pips::SolveResult& result, const pips::SolutionCount& reference)
+{
+    const auto expected = reference.count > 0 ? pips::SolveStatus::SOLVED : pips::SolveStatus::UNSATISFIABLE;
+    if (result.status != expected)
+        return std::format("{} where the reference counts {}", pips::to_string(result.status), reference.count);
+    if (result.solution && !valid_solution(game, *result.solution))
+        return "an invalid solution";
+    return {};
+}
+
+// Hints from every prefix of `solution`, growing then shrinking, so the hint solver both pushes
+// and pops between calls. Each must find a solution that starts with the prefix.
+std::string check_hints(const pips::Game& game, std::span<const pips::DominoPlacement> solution)
+{
+    pips::HintSolver hints(game, {.transposition_bytes = TABLE_BYTES});
+    std::vector<std::size_t> lengths;
+    for (std::size_t length = 0; length <= solution.size(); ++length) {
+        lengths.push_back(length);
+    }
+    for (std::size_t length = solution.size(); length-- > 0;) {
+        lengths.push_back(length);
+    }
+
+    for (const auto length : lengths) {
+        const auto prefix = solution.first(length);
+        const auto result = hints.solve(prefix);
+        if (!result)
+            return std::format("prefix of {} rejected: {}", length, result.error());
+        if (result->status != pips::SolveStatus::SOLVED || !valid_solution(game, *result->solution))
+            return std::format("prefix of {} gave {}", length, pips::to_string(result->status));
+        if (!std::ranges::equal(prefix, std::span(*result->solution).first(length), same_placement))
+            return std::format("prefix of {} not kept", length);
+    }
+    return {};
+}
+
+}  // namespace
+
+int main()
+{
+    // The plainest search is the reference, each option only adds pruning on top of it
+    std::vector<Configuration> configurations;
+    for (const auto branching : {pips::BranchingHeuristic::ROW_MAJOR, pips::BranchingHeuristic::MOST_CONSTRAINED}) {
+        for (int flags = 0; flags < 16; ++flags) {
+            configurations.push_back(engine_configuration(pips::EngineKind::BACKTRACKING,
+                                                          {.branching = branching,
+                                                           .forward_checking = (flags & 1) != 0,
+                                                           .backjumping = (flags & 2) != 0,
+                                                           .region_pruning = (flags & 4) != 0,
+                                                           .zone_assignments = (flags & 8) != 0}));
+        }
+    }
+    // Dead states remembered with and without nogoods, and shuffled orders
+    for (const bool backjumping : {false, true}) {
+        configurations.push_back(engine_configuration(
+            pips::EngineKind::BACKTRACKING, {.transposition_bytes = TABLE_BYTES, .backjumping = backjumping}));
+    }
+    configurations.push_back(engine_configuration(pips::EngineKind::BACKTRACKING, {.seed = 7}));
+    configurations.push_back(
+        engine_configuration(pips::EngineKind::BACKTRACKING, {.transposition_bytes = TABLE_BYTES, .seed = 11}));
+    // Small boards fit the one-word solver, the full-size one must count the same
+    configurations.push_back({"Solver (128 cells) table",
+                              [](const pips::Game& game) {
+                                  return pips::Solver(game, {.transposition_bytes = TABLE_BYTES})
+                                      .count_solutions(COUNT_LIMIT);
+                              }});
+    configurations.push_back(engine_configuration(pips::EngineKind::DANCING_LINKS, {}));
+
+    std::mt19937 rng(20251017);
+    int          failures = 0;
+    const auto   fail = [&](unsigned board, std::string_view what, const std::string& problem) {
+        if (problem.empty())
+            return;
+        std::println("board {}: {} gives {}", board, what, problem);
+        failures++;
+    };
+    for (unsigned board = 0; board < BOARDS; ++board) {
+        const auto game = random_game(rng);
+
+        std::vector<pips::SolutionCount> counts;
+        for (const auto& configuration : configurations) {
+            counts.push_back(configuration.count(game));
+        }
+
+        const auto& reference = counts.front();
+        for (std::size_t i = 1; i < counts.size(); ++i) {
+            if (counts[i].count == reference.count && counts[i].complete == reference.complete)
+                continue;
+            std::println("board {}: {} counts {}{}, {} counts {}{}",
+                         board,
+                         configurations[i].name,
+                         counts[i].count,
+                         counts[i].complete ? "" : "+",
+                         configurations[0].name,
+                         reference.count,
+                         reference.complete ? "" : "+");
+            failures++;
+        }
+
+        // One more pip asked of a zone often leaves no solution
+        auto unsolvable = game;
+        for (auto& zone : unsolvable.zones) {
+            if (zone.target) {
+                zone.target = static_cast<std::uint8_t>(*zone.target + 1);
+                break;
+            }
+        }
+        unsolvable.tables = pips::build_tables(unsolvable);
+        const auto unsolvable_reference = configurations.front().count(unsolvable);
+
+        // The plainest search leaves subtrees large enough for busy workers to split them
+        const auto check_parallel = [&](const pips::Game& variant, const pips::SolutionCount& variant_reference) {
+            const auto what = &variant == &game ? "the board" : "the unsolvable copy";
+            for (const auto& options : {PLAINEST, pips::SolverOptions{.transposition_bytes = TABLE_BYTES}}) {
+                pips::ParallelSolver parallel(variant, options, PARALLEL_THREADS);
+                auto problem = check_result(variant, parallel.solve(pips::SolveLimits{}), variant_reference);
+
+                // With nothing pruned or learned, a proof that there is no solution walks the whole
+                // tree, split levels only add the nodes they expand again. Fewer nodes than one
+                // thread visits means a subtree was lost.
+                if (problem.empty() && variant_reference.count == 0 && options.transposition_bytes == 0) {
+                    pips::Solver single(variant, options);
+                    if (single.solve(pips::SolveLimits{}).status == pips::SolveStatus::UNSATISFIABLE &&
+                        parallel.stats().nodes < single.stats().nodes) {
+                        problem = std::format(
+                            "{} nodes where one thread visits {}", parallel.stats().nodes, single.stats().nodes);
+                    }
+                }
+                fail(board, std::format("{} on {} threads, {}", what, PARALLEL_THREADS, describe(options)), problem);
+            }
+        };
+        check_parallel(game, reference);
+        check_parallel(unsolvable, unsolvable_reference);
+
+        if (const auto solution = pips::Solver(game).solve())
+            fail(board, "hints from its solution", check_hints(game, *solution));
+    }
+
+    if (failures != 0) {
+        std::println("{} failures over {} boards", failures, BOARDS);
+        return EXIT_FAILURE;
+    }
+    std::println("{} boards, {} configurations agree", BOARDS, configurations.size());
+    return EXIT_SUCCESS;
+}